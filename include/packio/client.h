@@ -8,19 +8,31 @@
 //! @file
 //! Class @ref packio::client "client"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <deque>
 #include <functional>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
+#include <string>
 #include <string_view>
 #include <type_traits>
 #include <optional>
+#include <vector>
 
+#include "internal/buffer_reserve.h"
+#include "internal/concurrency_limit.h"
 #include "internal/config.h"
+#include "internal/expected.h"
 #include "internal/manual_strand.h"
 #include "internal/movable_function.h"
+#include "internal/pending_calls.h"
 #include "internal/rpc.h"
+#include "internal/timer_wheel.h"
 #include "internal/utils.h"
 #include "traits.h"
 
@@ -30,6 +42,7 @@ namespace packio {
 //! @tparam Rpc RPC protocol implementation
 //! @tparam Socket Socket type to use for this client
 //! @tparam Map Container used to associate call IDs and handlers
+//! of long-lived calls, recent calls are stored in a slot array
 template <typename Rpc, typename Socket, template <class...> class Map = default_map>
 class client : public std::enable_shared_from_this<client<Rpc, Socket, Map>> {
 public:
@@ -45,16 +58,32 @@ public:
     using protocol_type = typename socket_type::protocol_type;
     //! The executor type
     using executor_type = typename socket_type::executor_type;
+    //! The clock used for call timeouts
+    using clock_type = std::chrono::steady_clock;
+    //! The pre-encoded part of the requests to a procedure, see @ref prepare
+    using prepared_request_type = typename rpc_type::prepared_request_type;
+    //! The result of a typed call, see @ref async_call_as
+    template <typename R>
+    using call_result = internal::expected<R, call_error>;
+    //! The prepared requests of the procedures of a server, indexed by
+    //! name, see @ref async_get_method_ids
+    using method_ids_type =
+        std::map<std::string, prepared_request_type, std::less<>>;
 
     using std::enable_shared_from_this<client<Rpc, Socket, Map>>::shared_from_this;
 
     //! The default size reserved by the reception buffer
     static constexpr size_t kDefaultBufferReserveSize = 4096;
+    //! The default maximum size reserved by the reception buffer
+    static constexpr size_t kDefaultMaxBufferReserveSize = 65536;
 
     //! The constructor
     //! @param socket The socket which the client will use. Can be connected or not
     explicit client(socket_type socket)
-        : socket_{std::move(socket)}, strand_{socket_.get_executor()}, wstrand_{strand_}
+        : socket_{std::move(socket)},
+          strand_{socket_.get_executor()},
+          wstrand_{socket_, strand_},
+          timer_{socket_.get_executor()}
     {
     }
 
@@ -65,14 +94,145 @@ public:
     const socket_type& socket() const noexcept { return socket_; }
 
     //! Set the size reserved by the reception buffer
+    //!
+    //! This is the minimum size, the reservation grows up to
+    //! @ref set_max_buffer_reserve_size "the maximum size" while
+    //! reads fill it and shrinks back when they do not.
     void set_buffer_reserve_size(std::size_t size) noexcept
     {
-        buffer_reserve_size_ = size;
+        buffer_reserve_.set_min(size);
     }
     //! Get the size reserved by the reception buffer
     std::size_t get_buffer_reserve_size() const noexcept
     {
-        return buffer_reserve_size_;
+        return buffer_reserve_.get_min();
+    }
+
+    //! Set the maximum size reserved by the reception buffer
+    //!
+    //! The reservation doubles after each read that fills it, up to this
+    //! size, so large messages are received with fewer reads. A value not
+    //! larger than the buffer reserve size disables the adaptation.
+    void set_max_buffer_reserve_size(std::size_t size) noexcept
+    {
+        buffer_reserve_.set_max(size);
+    }
+    //! Get the maximum size reserved by the reception buffer
+    std::size_t get_max_buffer_reserve_size() const noexcept
+    {
+        return buffer_reserve_.get_max();
+    }
+
+    //! Keep reading when no call is pending
+    //!
+    //! By default the client stops reading when all calls are complete
+    //! and cancels the read operation when the last call is cancelled.
+    //! When enabled, reading continues across idle periods, which avoids
+    //! restarting the read operation on each idle to busy transition.
+    //! The read operation keeps the client alive, and the execution
+    //! context busy, until the connection is closed.
+    void set_keep_reading(bool keep_reading) noexcept
+    {
+        keep_reading_ = keep_reading;
+    }
+    //! Check if the client keeps reading when no call is pending
+    bool get_keep_reading() const noexcept { return keep_reading_; }
+
+    //! Complete the calls inline on the read strand
+    //!
+    //! By default, the handler of a call is posted to the socket executor
+    //! when its response is received. When enabled, the handler is invoked
+    //! directly from the read strand, which saves a queue hop per response.
+    //! Handlers must then be short and must not block, no response is read
+    //! while they run. In both modes, a handler with an associated executor
+    //! is invoked through this executor.
+    void set_inline_completion(bool inline_completion) noexcept
+    {
+        inline_completion_ = inline_completion;
+    }
+    //! Check if the calls are completed inline on the read strand
+    bool get_inline_completion() const noexcept { return inline_completion_; }
+
+    //! Set the maximum number of bytes gathered in a single write
+    //!
+    //! Requests queued while a write is in progress are gathered
+    //! into a single write, up to this size. A single request
+    //! larger than this size is still written.
+    void set_max_write_size(std::size_t size) noexcept
+    {
+        wstrand_.set_max_write_size(size);
+    }
+    //! Get the maximum number of bytes gathered in a single write
+    std::size_t get_max_write_size() const noexcept
+    {
+        return wstrand_.get_max_write_size();
+    }
+
+    //! Set the maximum number of requests gathered in a single write
+    void set_max_write_buffers(std::size_t count) noexcept
+    {
+        wstrand_.set_max_write_buffers(count);
+    }
+    //! Get the maximum number of requests gathered in a single write
+    std::size_t get_max_write_buffers() const noexcept
+    {
+        return wstrand_.get_max_write_buffers();
+    }
+
+    //! Set the timeout of the calls
+    //!
+    //! Calls that have not received a response when the timeout expires
+    //! are completed with net::error::timed_out. Deadlines of all calls
+    //! are handled by a single timer. A duration of zero, the default,
+    //! disables the timeout. Only affects calls made after this function.
+    //! Once the last call timed out, the client stops reading, unless
+    //! the socket cannot cancel reads, like SSL streams and websockets.
+    void set_call_timeout(clock_type::duration timeout) noexcept
+    {
+        call_timeout_ = timeout;
+    }
+    //! Get the timeout of the calls
+    clock_type::duration get_call_timeout() const noexcept
+    {
+        return call_timeout_;
+    }
+
+    //! Set the maximum number of calls in flight
+    //!
+    //! Calls initiated while this many calls wait for their response are
+    //! queued before serialization, and sent when a call completes. Queued
+    //! calls are counted as pending and can be cancelled, their timeout
+    //! starts when they are sent. Batches are not limited. Zero, the
+    //! default, disables the limit. Must be set before making calls.
+    void set_max_in_flight(std::size_t max) noexcept { limit_.set_max(max); }
+    //! Get the maximum number of calls in flight
+    std::size_t get_max_in_flight() const noexcept { return limit_.get_max(); }
+
+    //! Adapt the number of calls in flight to the round-trip time
+    //!
+    //! When enabled, the limit set with @ref set_max_in_flight is an
+    //! upper bound. The actual limit grows while calls complete quickly,
+    //! and shrinks when their round-trip time increases or they time out.
+    void set_adaptive_in_flight(bool adaptive) noexcept
+    {
+        limit_.set_adaptive(adaptive);
+    }
+    //! Check if the number of calls in flight is adaptive
+    bool get_adaptive_in_flight() const noexcept
+    {
+        return limit_.get_adaptive();
+    }
+
+    //! Get the current limit of calls in flight, from any thread
+    std::size_t get_in_flight_limit() const noexcept { return limit_.limit(); }
+
+    //! Get the number of pending calls
+    //!
+    //! Calls are pending from the moment they are initiated until
+    //! their handler is scheduled for execution.
+    std::size_t pending_calls() const noexcept
+    {
+        return pending_count_.load(std::memory_order_relaxed);
     }
 
     //! Get the executor associated with the object
@@ -87,7 +247,10 @@ public:
         PACKIO_TRACE("cancel {}", rpc_type::format_id(id));
         net::dispatch(strand_, [self = shared_from_this(), id] {
             auto ec = make_error_code(net::error::operation_aborted);
-            self->async_call_handler(id, ec, {});
+            if (!self->cancel_queued_call(id, ec)) {
+                self->async_call_handler(id, ec, {});
+            }
+            self->maybe_stop_timer();
             self->maybe_cancel_reading();
         });
     }
@@ -100,9 +263,8 @@ public:
         PACKIO_TRACE("cancel all");
         net::dispatch(strand_, [self = shared_from_this()] {
             auto ec = make_error_code(net::error::operation_aborted);
-            while (!self->pending_.empty()) {
-                self->async_call_handler(self->pending_.begin()->first, ec, {});
-            }
+            self->async_call_handlers(ec);
+            self->maybe_stop_timer();
             self->maybe_cancel_reading();
         });
     }
@@ -185,30 +347,264 @@ public:
             name, std::tuple{}, std::forward<CallHandler>(handler), call_id);
     }
 
+    //! Prepare the calls to a remote procedure
+    //!
+    //! The procedure name and the constant part of the request are
+    //! encoded once. Calls made with the returned object only encode
+    //! the call ID and the arguments. The returned object does not
+    //! depend on the client and can be used with any client using
+    //! the same RPC protocol.
+    //! @param name Remote procedure name
+    static prepared_request_type prepare(std::string_view name)
+    {
+        return rpc_type::prepare_request(name);
+    }
+
+    //! Prepare the calls to a remote procedure identified by a numeric ID
+    //!
+    //! The requests carry the ID instead of the procedure name. IDs are
+    //! assigned by frozen dispatchers and listed by the procedure named
+    //! dispatcher::kMethodIdsProcedure, use @ref async_get_method_ids to
+    //! fetch them. Servers not assigning this ID reply with an
+    //! "unknown function" error.
+    //! @param name Remote procedure name, used for logging only
+    //! @param method_id Numeric ID of the remote procedure
+    static prepared_request_type prepare(std::string_view name, std::uint64_t method_id)
+    {
+        return rpc_type::prepare_request(name, method_id);
+    }
+
+    //! Fetch the numeric method IDs of the server
+    //!
+    //! Call the procedure listing the IDs of a frozen dispatcher and
+    //! @ref prepare a request for each procedure. The IDs are bound to
+    //! the set of procedures of the dispatcher: a server with other
+    //! procedures rejects them with an "unknown function" error.
+    //! @param handler Handler called with the prepared requests
+    //! Must satisfy the @ref traits::MethodIdsHandler trait
+    template <
+        PACKIO_COMPLETION_TOKEN_FOR(void(error_code, call_result<method_ids_type>))
+            MethodIdsHandler PACKIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+    auto async_get_method_ids(
+        MethodIdsHandler&& handler PACKIO_DEFAULT_COMPLETION_TOKEN(executor_type))
+    {
+        return net::async_initiate<
+            MethodIdsHandler,
+            void(error_code, call_result<method_ids_type>)>(
+            initiate_async_get_method_ids(this), handler);
+    }
+
+    //! Call a remote procedure prepared with @ref prepare
+    //! @see async_call
+    template <
+        PACKIO_COMPLETION_TOKEN_FOR(void(error_code, response_type))
+            CallHandler PACKIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type),
+        typename ArgsTuple,
+        typename = std::enable_if_t<internal::is_tuple_v<ArgsTuple>>>
+    auto async_call(
+        const prepared_request_type& request,
+        ArgsTuple&& args,
+        CallHandler&& handler PACKIO_DEFAULT_COMPLETION_TOKEN(executor_type),
+        std::optional<std::reference_wrapper<id_type>> call_id = std::nullopt)
+    {
+        return net::async_initiate<CallHandler, void(error_code, response_type)>(
+            initiate_async_call(this),
+            handler,
+            request,
+            std::forward<ArgsTuple>(args),
+            call_id);
+    }
+
+    //! @overload
+    template <
+        PACKIO_COMPLETION_TOKEN_FOR(void(error_code, response_type))
+            CallHandler PACKIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type),
+        typename = std::enable_if_t<!internal::is_tuple_v<CallHandler>>>
+    auto async_call(
+        const prepared_request_type& request,
+        CallHandler&& handler PACKIO_DEFAULT_COMPLETION_TOKEN(executor_type),
+        std::optional<std::reference_wrapper<id_type>> call_id = std::nullopt)
+    {
+        return async_call(
+            request, std::tuple{}, std::forward<CallHandler>(handler), call_id);
+    }
+
+    //! Call a remote procedure and convert its result
+    //!
+    //! The result is converted to R when the response is received, the
+    //! handler gets either the converted value or the error returned by
+    //! the procedure. The handler is called with a non-null error_code
+    //! when the call itself fails.
+    //!
+    //! The response is still parsed into the native @ref response_type
+    //! first: the parser reads it before its id identifies the call, so
+    //! it cannot know R. The conversion is done once, on the completion
+    //! path, and the native response is released right after it. This
+    //! function is not named async_call<R> because the first template
+    //! parameter of @ref async_call is its completion token.
+    //! @tparam R Type of the result
+    //! @param name Remote procedure name to call
+    //! @param args Tuple of arguments to pass to the remote procedure
+    //! @param handler Handler called with the converted result
+    //! Must satisfy the @ref traits::TypedCallHandler trait
+    template <
+        typename R,
+        PACKIO_COMPLETION_TOKEN_FOR(void(error_code, call_result<R>))
+            TypedCallHandler PACKIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type),
+        typename ArgsTuple,
+        typename = std::enable_if_t<internal::is_tuple_v<ArgsTuple>>>
+    auto async_call_as(
+        std::string_view name,
+        ArgsTuple&& args,
+        TypedCallHandler&& handler PACKIO_DEFAULT_COMPLETION_TOKEN(executor_type))
+    {
+        return net::async_initiate<TypedCallHandler, void(error_code, call_result<R>)>(
+            initiate_async_typed_call<R>(this),
+            handler,
+            name,
+            std::forward<ArgsTuple>(args));
+    }
+
+    //! @overload
+    template <
+        typename R,
+        PACKIO_COMPLETION_TOKEN_FOR(void(error_code, call_result<R>))
+            TypedCallHandler PACKIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type),
+        typename = std::enable_if_t<!internal::is_tuple_v<TypedCallHandler>>>
+    auto async_call_as(
+        std::string_view name,
+        TypedCallHandler&& handler PACKIO_DEFAULT_COMPLETION_TOKEN(executor_type))
+    {
+        return async_call_as<R>(
+            name, std::tuple{}, std::forward<TypedCallHandler>(handler));
+    }
+
+    //! Call a remote procedure prepared with @ref prepare
+    //! and convert its result
+    //! @see async_call_as
+    template <
+        typename R,
+        PACKIO_COMPLETION_TOKEN_FOR(void(error_code, call_result<R>))
+            TypedCallHandler PACKIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type),
+        typename ArgsTuple,
+        typename = std::enable_if_t<internal::is_tuple_v<ArgsTuple>>>
+    auto async_call_as(
+        const prepared_request_type& request,
+        ArgsTuple&& args,
+        TypedCallHandler&& handler PACKIO_DEFAULT_COMPLETION_TOKEN(executor_type))
+    {
+        return net::async_initiate<TypedCallHandler, void(error_code, call_result<R>)>(
+            initiate_async_typed_call<R>(this),
+            handler,
+            request,
+            std::forward<ArgsTuple>(args));
+    }
+
+    //! @overload
+    template <
+        typename R,
+        PACKIO_COMPLETION_TOKEN_FOR(void(error_code, call_result<R>))
+            TypedCallHandler PACKIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type),
+        typename = std::enable_if_t<!internal::is_tuple_v<TypedCallHandler>>>
+    auto async_call_as(
+        const prepared_request_type& request,
+        TypedCallHandler&& handler PACKIO_DEFAULT_COMPLETION_TOKEN(executor_type))
+    {
+        return async_call_as<R>(
+            request, std::tuple{}, std::forward<TypedCallHandler>(handler));
+    }
+
+    //! Call several remote procedures with a single write
+    //!
+    //! All the requests are serialized in a single buffer, sent as a
+    //! JSON-RPC batch by JSON-based protocols. The handler is called
+    //! once all the calls are complete, with the responses in the order
+    //! of the calls. If any call fails, the handler is called with the
+    //! first error and the responses of the failed calls are empty.
+    //! @param calls Range of calls, std::get<0> must return the name of
+    //! the procedure and std::get<1> the tuple of arguments of each element
+    //! @param handler Handler called with the responses
+    //! Must satisfy the @ref traits::CallBatchHandler trait
+    template <
+        PACKIO_COMPLETION_TOKEN_FOR(void(error_code, std::vector<response_type>))
+            CallBatchHandler PACKIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type),
+        typename CallRange>
+    auto async_call_batch(
+        const CallRange& calls,
+        CallBatchHandler&& handler PACKIO_DEFAULT_COMPLETION_TOKEN(executor_type))
+    {
+        return net::async_initiate<
+            CallBatchHandler,
+            void(error_code, std::vector<response_type>)>(
+            initiate_async_call_batch(this), handler, calls);
+    }
+
 private:
     using parser_type = typename rpc_type::incremental_parser_type;
     using async_call_handler_type =
         internal::movable_function<void(error_code, response_type)>;
 
+    //! A call waiting for a free slot, see @ref set_max_in_flight
+    struct queued_call {
+        std::uint64_t seq;
+        //! Send the call, or complete it with the error
+        internal::movable_function<void(error_code)> start;
+    };
+
+    template <typename Method>
+    using stored_method_t = std::conditional_t<
+        std::is_same_v<Method, prepared_request_type>,
+        prepared_request_type,
+        std::string>;
+
+    template <typename ArgsTuple>
+    static auto decay_tuple(ArgsTuple&& args)
+    {
+        return std::apply(
+            [](auto&&... args) {
+                return std::tuple<std::decay_t<decltype(args)>...>{
+                    std::forward<decltype(args)>(args)...};
+            },
+            std::forward<ArgsTuple>(args));
+    }
+
+    static std::string_view method_name(std::string_view name) { return name; }
+    static std::string_view method_name(const prepared_request_type& request)
+    {
+        return request.method;
+    }
+
     void close(error_code ec)
     {
         net::dispatch(strand_, [self = shared_from_this(), ec] {
-            while (!self->pending_.empty()) {
-                self->async_call_handler(self->pending_.begin()->first, ec, {});
-            }
+            self->async_call_handlers(ec);
+            self->maybe_stop_timer();
 
             error_code close_ec;
             self->socket_.close(close_ec);
             if (close_ec) {
                 PACKIO_WARN("close failed: {}", close_ec.message());
             }
+            // a pending read still uses the parser buffer,
+            // it resets the reception when it is aborted
+            if (!self->reading_) {
+                self->reset_reception();
+            }
         });
     }
 
+    void reset_reception()
+    {
+        assert(strand_.running_in_this_thread());
+        // partial data is meaningless on a new connection
+        parser_ = parser_type{};
+        buffer_reserve_.reset();
+    }
+
     void maybe_cancel_reading()
     {
         assert(strand_.running_in_this_thread());
-        if (reading_ && pending_.empty()) {
+        if (reading_ && pending_.empty() && !keep_reading_) {
             PACKIO_DEBUG("stop reading");
             error_code ec;
             socket_.cancel(ec);
@@ -218,35 +614,91 @@ private:
         }
     }
 
+    void async_wait_deadline()
+    {
+        assert(strand_.running_in_this_thread());
+        if (timer_armed_) {
+            // wake up earlier if a call has an earlier deadline
+            if (wheel_.next_expiry() < timer_.expiry()) {
+                timer_.cancel();
+            }
+            return;
+        }
+        if (wheel_.empty()) {
+            return;
+        }
+
+        timer_armed_ = true;
+        timer_.expires_at(wheel_.next_expiry());
+        timer_.async_wait(internal::bind_executor(
+            strand_, [self = shared_from_this()](error_code ec) {
+                assert(self->strand_.running_in_this_thread());
+                self->timer_armed_ = false;
+                if (ec != net::error::operation_aborted) {
+                    self->expire_calls();
+                }
+                self->async_wait_deadline();
+            }));
+    }
+
+    void expire_calls()
+    {
+        std::vector<async_call_handler_type> handlers;
+        wheel_.expire(clock_type::now(), [&](std::uint64_t seq) {
+            if (auto handler = pending_.take(seq)) {
+                handlers.push_back(std::move(handler));
+            }
+        });
+        if (!handlers.empty()) {
+            PACKIO_DEBUG("{} call(s) timed out", handlers.size());
+            post_handlers(
+                make_error_code(net::error::timed_out), std::move(handlers));
+        }
+        maybe_stop_timer();
+        if constexpr (internal::is_cancellable_v<socket_type>) {
+            maybe_cancel_reading();
+        }
+    }
+
+    void maybe_stop_timer()
+    {
+        assert(strand_.running_in_this_thread());
+        if (pending_.empty() && !wheel_.empty()) {
+            // all remaining deadlines belong to completed calls
+            wheel_.clear();
+            timer_.cancel();
+        }
+    }
+
     template <typename Buffer, typename WriteHandler>
     void async_send(std::unique_ptr<Buffer>&& buffer_ptr, WriteHandler&& handler)
     {
-        wstrand_.push([self = shared_from_this(),
-                       buffer_ptr = std::move(buffer_ptr),
-                       handler = std::forward<WriteHandler>(handler)]() mutable {
-            assert(self->strand_.running_in_this_thread());
-            internal::set_no_delay(self->socket_);
-
-            auto buf = rpc_type::buffer(*buffer_ptr);
-            net::async_write(
-                self->socket_,
-                buf,
-                internal::bind_executor(
-                    self->strand_,
-                    [self,
-                     buffer_ptr = std::move(buffer_ptr),
+        net::dispatch(
+            strand_,
+            [self = shared_from_this(),
+             buffer_ptr = std::move(buffer_ptr),
+             handler = std::forward<WriteHandler>(handler)]() mutable {
+                assert(self->strand_.running_in_this_thread());
+                internal::set_no_delay(self->socket_);
+
+                auto buf = rpc_type::buffer(*buffer_ptr);
+                self->wstrand_.push(
+                    buf,
+                    [buffer_ptr = std::move(buffer_ptr),
                      handler = std::forward<WriteHandler>(handler)](
                         error_code ec, size_t length) mutable {
-                        self->wstrand_.next();
                         handler(ec, length);
-                    }));
-        });
+                    });
+            });
     }
 
-    void async_read(parser_type&& parser)
+    void async_read()
     {
-        parser.reserve_buffer(buffer_reserve_size_);
-        auto buffer = net::buffer(parser.buffer(), parser.buffer_capacity());
+        // the parser is kept across read operations of a connection,
+        // data received before an idle period is not lost and its
+        // buffer is reused, it is reset when the socket is closed
+        parser_.reserve_buffer(buffer_reserve_.size());
+        auto buffer = net::buffer(parser_.buffer(), parser_.buffer_capacity());
 
         assert(strand_.running_in_this_thread());
         reading_ = true;
@@ -255,8 +707,7 @@ private:
             buffer,
             internal::bind_executor(
                 strand_,
-                [this, self = shared_from_this(), parser = std::move(parser)](
-
+                [this, self = shared_from_this()](
                     error_code ec, size_t length) mutable {
                     // stop if there is an error or there is no more pending calls
                     assert(self->strand_.running_in_this_thread());
@@ -264,16 +715,27 @@ private:
                     if (ec) {
                         PACKIO_WARN("read error: {}", ec.message());
                         self->reading_ = false;
-                        if (ec != net::error::operation_aborted)
+                        if (ec != net::error::operation_aborted) {
+                            self->reset_reception();
                             self->close(ec);
+                        }
+                        else if (!self->socket_.is_open()) {
+                            // the socket was closed, it may be reopened
+                            self->reset_reception();
+                        }
+                        else if (!self->pending_.empty()) {
+                            // calls made after the cancellation need a reader
+                            self->async_read();
+                        }
                         return;
                     }
 
                     PACKIO_TRACE("read: {}", length);
-                    parser.buffer_consumed(length);
+                    self->parser_.buffer_consumed(length);
+                    const bool shrunk = self->buffer_reserve_.on_read(length);
 
                     while (true) {
-                        auto response = parser.get_response();
+                        auto response = self->parser_.get_response();
                         if (!response) {
                             PACKIO_INFO("stop reading: {}", response.error());
                             break;
@@ -281,13 +743,21 @@ private:
                         self->async_call_handler(std::move(*response));
                     }
 
+                    if (shrunk) {
+                        // release the capacity grown for larger responses
+                        self->parser_.shrink_buffer();
+                    }
+
                     if (self->pending_.empty()) {
-                        PACKIO_TRACE("done reading, no more pending calls");
-                        self->reading_ = false;
-                        return;
+                        self->maybe_stop_timer();
+                        if (!self->keep_reading_) {
+                            PACKIO_TRACE("done reading, no more pending calls");
+                            self->reading_ = false;
+                            return;
+                        }
                     }
 
-                    self->async_read(std::move(parser));
+                    self->async_read();
                 }));
     }
 
@@ -299,39 +769,229 @@ private:
 
     void async_call_handler(id_type id, error_code ec, response_type&& response)
     {
-        net::dispatch(
-            strand_,
-            [ec,
-             id,
-             self = shared_from_this(),
-             response = std::move(response)]() mutable {
-                PACKIO_DEBUG(
-                    "calling handler for id: {}", rpc_type::format_id(id));
+        PACKIO_DEBUG("calling handler for id: {}", rpc_type::format_id(id));
 
-                assert(self->strand_.running_in_this_thread());
-                auto it = self->pending_.find(id);
-                if (it == self->pending_.end()) {
-                    PACKIO_WARN("unexisting id: {}", rpc_type::format_id(id));
-                    return;
-                }
+        assert(strand_.running_in_this_thread());
+        auto seq = rpc_type::integer_id(id);
+        auto handler = seq ? pending_.take(*seq) : nullptr;
+        if (!handler) {
+            PACKIO_WARN("unexisting id: {}", rpc_type::format_id(id));
+            return;
+        }
+        pending_count_.fetch_sub(1, std::memory_order_relaxed);
 
-                auto handler = std::move(it->second);
-                self->pending_.erase(it);
+        if (inline_completion_) {
+            handler(ec, std::move(response));
+            return;
+        }
+
+        // handle the response asynchronously (post)
+        // to schedule the next read immediately
+        // this will allow parallel response handling
+        // in multi-threaded environments
+        net::post(
+            socket_.get_executor(),
+            [ec,
+             handler = std::move(handler),
+             response = std::move(response)]() mutable {
+                handler(ec, std::move(response));
+            });
+    }
 
-                // handle the response asynchronously (post)
-                // to schedule the next read immediately
-                // this will allow parallel response handling
-                // in multi-threaded environments
-                net::post(
-                    self->socket_.get_executor(),
+    template <typename Handler>
+    static auto make_call_handler(Handler&& handler)
+    {
+        using handler_executor_type = net::associated_executor_t<Handler>;
+        if constexpr (std::is_same_v<handler_executor_type, net::system_executor>) {
+            // no associated executor, run where the response is delivered
+            return std::forward<Handler>(handler);
+        }
+        else {
+            return [handler = std::forward<Handler>(handler)](
+                       error_code ec, response_type response) mutable {
+                auto executor = net::get_associated_executor(handler);
+                net::dispatch(
+                    executor,
                     [ec,
                      handler = std::move(handler),
                      response = std::move(response)]() mutable {
                         handler(ec, std::move(response));
                     });
+            };
+        }
+    }
+
+    void async_call_handlers(error_code ec)
+    {
+        assert(strand_.running_in_this_thread());
+        fail_queued_calls(ec);
+        if (pending_.empty()) {
+            return;
+        }
+
+        post_handlers(ec, pending_.take_all());
+    }
+
+    void post_handlers(error_code ec, std::vector<async_call_handler_type> handlers)
+    {
+        pending_count_.fetch_sub(handlers.size(), std::memory_order_relaxed);
+
+        // complete all the calls at once, with a single post
+        net::post(
+            socket_.get_executor(),
+            [ec, handlers = std::move(handlers)]() mutable {
+                for (auto& handler : handlers) {
+                    handler(ec, response_type{});
+                }
+            });
+    }
+
+    template <typename CallHandler, typename Method, typename ArgsTuple>
+    void start_call(
+        id_type call_id,
+        CallHandler&& handler,
+        const Method& name,
+        ArgsTuple&& args,
+        bool limited)
+    {
+        auto packer_buf = internal::to_unique_ptr(std::apply(
+            [&name, &call_id](auto&&... args) {
+                return rpc_type::serialize_request(
+                    call_id, name, std::forward<decltype(args)>(args)...);
+            },
+            std::forward<ArgsTuple>(args)));
+
+        net::dispatch(
+            strand_,
+            [self = shared_from_this(),
+             call_id,
+             limited,
+             handler = std::forward<CallHandler>(handler),
+             packer_buf = std::move(packer_buf)]() mutable {
+                // we must emplace the id and handler before sending data
+                // otherwise we might drop a fast response
+                assert(self->strand_.running_in_this_thread());
+                auto seq = *rpc_type::integer_id(call_id);
+                auto call_handler = make_call_handler(std::move(handler));
+                if (limited) {
+                    // free the slot of the call when it completes, wrap the
+                    // handler before type erasure so that it is stored inline
+                    auto limited_handler = [self,
+                                            start = clock_type::now(),
+                                            call_handler = std::move(call_handler)](
+                                               error_code ec,
+                                               response_type response) mutable {
+                        self->release_call(ec, clock_type::now() - start);
+                        call_handler(ec, std::move(response));
+                    };
+                    self->pending_.insert(seq, std::move(limited_handler));
+                }
+                else {
+                    self->pending_.insert(seq, std::move(call_handler));
+                }
+
+                if (self->call_timeout_ > clock_type::duration::zero()) {
+                    self->wheel_.insert(
+                        seq, clock_type::now() + self->call_timeout_);
+                    self->async_wait_deadline();
+                }
+
+                // if we are not reading, start the read operation
+                if (!self->reading_) {
+                    PACKIO_DEBUG("start reading");
+                    self->async_read();
+                }
+
+                // send the request buffer
+                self->async_send(
+                    std::move(packer_buf),
+                    [self = std::move(self), call_id](
+                        error_code ec, std::size_t length) mutable {
+                        if (ec) {
+                            PACKIO_WARN("write error: {}", ec.message());
+                            if (ec != net::error::operation_aborted)
+                                self->close(ec);
+                            return;
+                        }
+
+                        PACKIO_TRACE("write: {}", length);
+                        (void)length;
+                    });
             });
     }
 
+    void enqueue_call(queued_call&& call)
+    {
+        assert(strand_.running_in_this_thread());
+        if (queued_calls_.empty() && in_flight_ < limit_.limit()) {
+            ++in_flight_;
+            call.start({});
+            return;
+        }
+        PACKIO_TRACE(
+            "in-flight limit reached, {} call(s) queued",
+            queued_calls_.size() + 1);
+        queued_calls_.push_back(std::move(call));
+    }
+
+    void release_call(error_code ec, clock_type::duration rtt)
+    {
+        net::dispatch(strand_, [self = shared_from_this(), ec, rtt] {
+            assert(self->in_flight_ > 0);
+            --self->in_flight_;
+            // only responses and timeouts tell about the server load
+            if (!ec || ec == net::error::timed_out) {
+                self->limit_.on_complete(
+                    rtt,
+                    ec == net::error::timed_out,
+                    self->in_flight_,
+                    clock_type::now());
+            }
+            self->start_queued_calls();
+        });
+    }
+
+    void start_queued_calls()
+    {
+        assert(strand_.running_in_this_thread());
+        while (!queued_calls_.empty() && in_flight_ < limit_.limit()) {
+            auto call = std::move(queued_calls_.front());
+            queued_calls_.pop_front();
+            ++in_flight_;
+            call.start({});
+        }
+    }
+
+    bool cancel_queued_call(id_type id, error_code ec)
+    {
+        assert(strand_.running_in_this_thread());
+        if (queued_calls_.empty()) {
+            return false;
+        }
+        auto seq = rpc_type::integer_id(id);
+        auto it = std::find_if(
+            queued_calls_.begin(), queued_calls_.end(), [&](const auto& call) {
+                return seq && call.seq == *seq;
+            });
+        if (it == queued_calls_.end()) {
+            return false;
+        }
+        auto call = std::move(*it);
+        queued_calls_.erase(it);
+        call.start(ec);
+        return true;
+    }
+
+    void fail_queued_calls(error_code ec)
+    {
+        assert(strand_.running_in_this_thread());
+        auto calls = std::move(queued_calls_);
+        queued_calls_.clear();
+        for (auto& call : calls) {
+            call.start(ec);
+        }
+    }
+
     class initiate_async_notify {
     public:
         using executor_type = typename client::executor_type;
@@ -394,50 +1054,283 @@ private:
             return self_->get_executor();
         }
 
-        template <typename CallHandler, typename ArgsTuple>
+        template <typename CallHandler, typename Method, typename ArgsTuple>
         void operator()(
             CallHandler&& handler,
-            std::string_view name,
+            const Method& name,
             ArgsTuple&& args,
             std::optional<std::reference_wrapper<id_type>> opt_call_id) const
         {
             PACKIO_STATIC_ASSERT_TTRAIT(CallHandler, rpc_type);
-            PACKIO_DEBUG("async_call: {}", name);
+            PACKIO_DEBUG("async_call: {}", method_name(name));
 
             id_type call_id = self_->id_.fetch_add(1, std::memory_order_acq_rel);
+            self_->pending_count_.fetch_add(1, std::memory_order_relaxed);
             if (opt_call_id) {
                 opt_call_id->get() = call_id;
             }
 
-            auto packer_buf = internal::to_unique_ptr(std::apply(
-                [&name, &call_id](auto&&... args) {
-                    return rpc_type::serialize_request(
-                        call_id, name, std::forward<decltype(args)>(args)...);
-                },
-                std::forward<ArgsTuple>(args)));
+            if (!self_->limit_.enabled()) {
+                self_->start_call(
+                    call_id,
+                    std::forward<CallHandler>(handler),
+                    name,
+                    std::forward<ArgsTuple>(args),
+                    false);
+                return;
+            }
 
+            // the call may be queued, it is serialized when it starts
+            auto start = [self = self_->shared_from_this(),
+                          call_id,
+                          handler = std::forward<CallHandler>(handler),
+                          name = stored_method_t<Method>{name},
+                          args = decay_tuple(std::forward<ArgsTuple>(args))](
+                             error_code ec) mutable {
+                if (ec) {
+                    self->pending_count_.fetch_sub(1, std::memory_order_relaxed);
+                    net::post(
+                        self->socket_.get_executor(),
+                        [ec,
+                         handler = make_call_handler(std::move(handler))]() mutable {
+                            handler(ec, response_type{});
+                        });
+                    return;
+                }
+                self->start_call(
+                    call_id, std::move(handler), name, std::move(args), true);
+            };
             net::dispatch(
                 self_->strand_,
                 [self = self_->shared_from_this(),
-                 call_id,
-                 handler = std::forward<CallHandler>(handler),
+                 call = queued_call{
+                     *rpc_type::integer_id(call_id),
+                     std::move(start)}]() mutable {
+                    self->enqueue_call(std::move(call));
+                });
+        }
+
+    private:
+        client* self_;
+    };
+
+    template <typename R>
+    class initiate_async_typed_call {
+    public:
+        using executor_type = typename client::executor_type;
+
+        explicit initiate_async_typed_call(client* self) : self_(self) {}
+
+        executor_type get_executor() const noexcept
+        {
+            return self_->get_executor();
+        }
+
+        template <typename TypedCallHandler, typename Method, typename ArgsTuple>
+        void operator()(
+            TypedCallHandler&& handler,
+            const Method& name,
+            ArgsTuple&& args) const
+        {
+            PACKIO_STATIC_ASSERT_TTRAIT(TypedCallHandler, call_result<R>);
+
+            // convert as soon as the response is received,
+            // the native response is released right after
+            auto executor = net::get_associated_executor(handler);
+            initiate_async_call{self_}(
+                net::bind_executor(
+                    executor,
+                    [handler = std::forward<TypedCallHandler>(handler)](
+                        error_code ec, response_type response) mutable {
+                        if (ec) {
+                            handler(
+                                ec,
+                                call_result<R>{internal::unexpected{
+                                    call_error{ec.message()}}});
+                            return;
+                        }
+                        handler(
+                            ec, rpc_type::template extract_result<R>(response));
+                    }),
+                name,
+                std::forward<ArgsTuple>(args),
+                std::nullopt);
+        }
+
+    private:
+        client* self_;
+    };
+
+    class initiate_async_get_method_ids {
+    public:
+        using executor_type = typename client::executor_type;
+
+        explicit initiate_async_get_method_ids(client* self) : self_(self) {}
+
+        executor_type get_executor() const noexcept
+        {
+            return self_->get_executor();
+        }
+
+        template <typename MethodIdsHandler>
+        void operator()(MethodIdsHandler&& handler) const
+        {
+            PACKIO_STATIC_ASSERT_TTRAIT(
+                MethodIdsHandler, call_result<method_ids_type>);
+
+            using ids_type = std::map<std::string, std::uint64_t>;
+            auto executor = net::get_associated_executor(handler);
+            initiate_async_typed_call<ids_type>{self_}(
+                net::bind_executor(
+                    executor,
+                    [handler = std::forward<MethodIdsHandler>(handler)](
+                        error_code ec, call_result<ids_type> ids) mutable {
+                        if (!ids) {
+                            handler(
+                                ec,
+                                call_result<method_ids_type>{
+                                    internal::unexpected{std::move(ids.error())}});
+                            return;
+                        }
+                        method_ids_type requests;
+                        for (const auto& [name, id] : *ids) {
+                            requests.emplace(name, prepare(name, id));
+                        }
+                        handler(ec, call_result<method_ids_type>{std::move(requests)});
+                    }),
+                internal::kMethodIdsProcedure,
+                std::tuple{});
+        }
+
+    private:
+        client* self_;
+    };
+
+    class initiate_async_call_batch {
+    public:
+        using executor_type = typename client::executor_type;
+
+        explicit initiate_async_call_batch(client* self) : self_(self) {}
+
+        executor_type get_executor() const noexcept
+        {
+            return self_->get_executor();
+        }
+
+        template <typename CallBatchHandler, typename CallRange>
+        void operator()(CallBatchHandler&& handler, const CallRange& calls) const
+        {
+            PACKIO_STATIC_ASSERT_TTRAIT(CallBatchHandler, rpc_type);
+
+            auto size = static_cast<std::size_t>(
+                std::distance(std::begin(calls), std::end(calls)));
+            PACKIO_DEBUG("async_call_batch: {} call(s)", size);
+
+            using handler_type = std::decay_t<CallBatchHandler>;
+            using handler_executor_type =
+                net::associated_executor_t<handler_type, executor_type>;
+            struct state {
+                state(
+                    handler_type handler,
+                    handler_executor_type executor,
+                    std::size_t size)
+                    : handler{std::move(handler)},
+                      executor{std::move(executor)},
+                      remaining{size},
+                      responses(size)
+                {
+                }
+
+                void complete()
+                {
+                    handler(ec, std::move(responses));
+                }
+
+                std::mutex mutex;
+                handler_type handler;
+                handler_executor_type executor;
+                std::size_t remaining;
+                error_code ec;
+                std::vector<response_type> responses;
+            };
+            auto executor = net::get_associated_executor(
+                handler, self_->get_executor());
+            auto shared_state = std::make_shared<state>(
+                std::forward<CallBatchHandler>(handler), executor, size);
+
+            if (size == 0) {
+                net::post(shared_state->executor, [shared_state]() {
+                    shared_state->complete();
+                });
+                return;
+            }
+
+            // reserve all the IDs at once
+            auto first_id = self_->id_.fetch_add(size, std::memory_order_acq_rel);
+            self_->pending_count_.fetch_add(size, std::memory_order_relaxed);
+
+            std::vector<id_type> call_ids;
+            std::vector<decltype(rpc_type::serialize_batch({}))> buffers;
+            call_ids.reserve(size);
+            buffers.reserve(size);
+            for (const auto& call : calls) {
+                id_type call_id = first_id + call_ids.size();
+                buffers.push_back(std::apply(
+                    [&](const auto&... args) {
+                        return rpc_type::serialize_request(
+                            call_id, std::get<0>(call), args...);
+                    },
+                    std::get<1>(call)));
+                call_ids.push_back(std::move(call_id));
+            }
+            auto packer_buf = internal::to_unique_ptr(
+                rpc_type::serialize_batch(std::move(buffers)));
+
+            net::dispatch(
+                self_->strand_,
+                [self = self_->shared_from_this(),
+                 call_ids = std::move(call_ids),
+                 shared_state = std::move(shared_state),
                  packer_buf = std::move(packer_buf)]() mutable {
-                    // we must emplace the id and handler before sending data
+                    // we must emplace the ids and handlers before sending data
                     // otherwise we might drop a fast response
                     assert(self->strand_.running_in_this_thread());
-                    self->pending_.try_emplace(call_id, std::move(handler));
+                    auto deadline = clock_type::now() + self->call_timeout_;
+                    for (std::size_t i = 0; i < call_ids.size(); ++i) {
+                        auto seq = *rpc_type::integer_id(call_ids[i]);
+                        self->pending_.insert(
+                            seq,
+                            [shared_state, i](
+                                error_code ec, response_type response) {
+                                std::unique_lock lock{shared_state->mutex};
+                                if (ec && !shared_state->ec) {
+                                    shared_state->ec = ec;
+                                }
+                                shared_state->responses[i] = std::move(response);
+                                if (--shared_state->remaining == 0) {
+                                    lock.unlock();
+                                    net::dispatch(
+                                        shared_state->executor, [shared_state]() {
+                                            shared_state->complete();
+                                        });
+                                }
+                            });
+                        if (self->call_timeout_ > clock_type::duration::zero()) {
+                            self->wheel_.insert(seq, deadline);
+                        }
+                    }
+                    self->async_wait_deadline();
 
                     // if we are not reading, start the read operation
                     if (!self->reading_) {
                         PACKIO_DEBUG("start reading");
-                        self->async_read(parser_type{});
+                        self->async_read();
                     }
 
-                    // send the request buffer
+                    // send all the requests at once
                     self->async_send(
                         std::move(packer_buf),
-                        [self = std::move(self), call_id](
-                            error_code ec, std::size_t length) mutable {
+                        [self](error_code ec, std::size_t length) mutable {
                             if (ec) {
                                 PACKIO_WARN("write error: {}", ec.message());
                                 if (ec != net::error::operation_aborted)
@@ -456,14 +1349,29 @@ private:
     };
 
     socket_type socket_;
-    std::size_t buffer_reserve_size_{kDefaultBufferReserveSize};
+    internal::buffer_reserve buffer_reserve_{
+        kDefaultBufferReserveSize,
+        kDefaultMaxBufferReserveSize};
     std::atomic<uint64_t> id_{0};
+    std::atomic<std::size_t> pending_count_{0};
 
     net::strand<executor_type> strand_;
-    internal::manual_strand<executor_type> wstrand_;
+    internal::manual_strand<socket_type> wstrand_;
 
-    Map<id_type, async_call_handler_type> pending_;
+    internal::pending_calls<async_call_handler_type, Map> pending_;
+    parser_type parser_;
     bool reading_{false};
+    bool keep_reading_{false};
+    bool inline_completion_{false};
+
+    internal::concurrency_limit limit_;
+    std::size_t in_flight_{0};
+    std::deque<queued_call> queued_calls_;
+
+    clock_type::duration call_timeout_{clock_type::duration::zero()};
+    internal::timer_wheel wheel_;
+    net::steady_timer timer_;
+    bool timer_armed_{false};
 };
 
 //! Create a client from a socket
@@ -0,0 +1,308 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_CLIENT_POOL_H
+#define PACKIO_CLIENT_POOL_H
+
+//! @file
+//! Class @ref packio::client_pool "client_pool"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "client.h"
+#include "internal/config.h"
+#include "internal/log.h"
+#include "internal/utils.h"
+#include "traits.h"
+
+namespace packio {
+
+//! The policy used by a @ref client_pool to select a client
+enum class balancing_policy {
+    //! Pick two clients at random, use the one with the fewest pending calls
+    power_of_two_choices,
+    //! Use the client with the fewest pending calls
+    least_pending,
+};
+
+//! The client_pool class
+//!
+//! Owns several clients, each one with its own connection,
+//! and routes each call to one of them.
+//! @tparam Rpc RPC protocol implementation
+//! @tparam Socket Socket type to use for the clients
+//! @tparam Map Container used by the clients to associate call IDs and handlers
+template <typename Rpc, typename Socket, template <class...> class Map = default_map>
+class client_pool {
+public:
+    //! The client type
+    using client_type = client<Rpc, Socket, Map>;
+    //! The RPC protocol type
+    using rpc_type = Rpc;
+    //! The response of a RPC call
+    using response_type = typename client_type::response_type;
+    //! The pre-encoded part of the requests to a procedure
+    using prepared_request_type = typename client_type::prepared_request_type;
+    //! The socket type
+    using socket_type = Socket;
+    //! The protocol type
+    using protocol_type = typename client_type::protocol_type;
+    //! The executor type
+    using executor_type = typename client_type::executor_type;
+
+    //! The constructor
+    //! @param clients The clients of the pool, must not be empty
+    explicit client_pool(std::vector<std::shared_ptr<client_type>> clients)
+        : clients_{std::move(clients)}
+    {
+        assert(!clients_.empty());
+    }
+
+    //! Get the clients of the pool
+    const std::vector<std::shared_ptr<client_type>>& clients() const noexcept
+    {
+        return clients_;
+    }
+
+    //! Get the number of clients in the pool
+    std::size_t size() const noexcept { return clients_.size(); }
+
+    //! Get the executor associated with the object
+    executor_type get_executor() { return clients_.front()->get_executor(); }
+
+    //! Set the policy used to select a client for each call
+    void set_balancing_policy(balancing_policy policy) noexcept
+    {
+        policy_ = policy;
+    }
+    //! Get the policy used to select a client for each call
+    balancing_policy get_balancing_policy() const noexcept { return policy_; }
+
+    //! Get the total number of pending calls
+    std::size_t pending_calls() const noexcept
+    {
+        std::size_t count = 0;
+        for (const auto& client : clients_) {
+            count += client->pending_calls();
+        }
+        return count;
+    }
+
+    //! Select the client that will handle the next call
+    const std::shared_ptr<client_type>& select()
+    {
+        auto n = clients_.size();
+        if (n == 1) {
+            return clients_.front();
+        }
+
+        if (policy_ == balancing_policy::least_pending) {
+            std::size_t best = 0;
+            std::size_t best_count = clients_[0]->pending_calls();
+            for (std::size_t i = 1; i < n && best_count > 0; ++i) {
+                auto count = clients_[i]->pending_calls();
+                if (count < best_count) {
+                    best = i;
+                    best_count = count;
+                }
+            }
+            return clients_[best];
+        }
+
+        auto rnd = mix(counter_.fetch_add(1, std::memory_order_relaxed));
+        auto first = rnd % n;
+        auto second = (first + 1 + (rnd >> 32) % (n - 1)) % n;
+        return clients_[first]->pending_calls()
+                       <= clients_[second]->pending_calls()
+                   ? clients_[first]
+                   : clients_[second];
+    }
+
+    //! Connect all the clients
+    //!
+    //! Clients are distributed round-robin over the endpoints. Connecting
+    //! the whole pool before the first call avoids paying for the
+    //! connection establishment on the first calls.
+    //! The socket type must provide async_connect.
+    //! @param endpoints The endpoints to connect to
+    //! @param handler Handler called when all the connections are
+    //! established or failed, with the first error encountered
+    template <
+        typename EndpointSequence,
+        PACKIO_COMPLETION_TOKEN_FOR(void(error_code))
+            ConnectHandler PACKIO_DEFAULT_COMPLETION_TOKEN_TYPE(executor_type)>
+    auto async_connect(
+        const EndpointSequence& endpoints,
+        ConnectHandler&& handler PACKIO_DEFAULT_COMPLETION_TOKEN(executor_type))
+    {
+        return net::async_initiate<ConnectHandler, void(error_code)>(
+            initiate_async_connect(this), handler, endpoints);
+    }
+
+    //! Cancel all pending calls of all clients
+    void cancel()
+    {
+        for (auto& client : clients_) {
+            client->cancel();
+        }
+    }
+
+    //! Send a notify request to the server using one of the clients
+    //! @see client::async_notify
+    template <typename... Args>
+    auto async_notify(std::string_view name, Args&&... args)
+    {
+        return select()->async_notify(name, std::forward<Args>(args)...);
+    }
+
+    //! Call a remote procedure using one of the clients
+    //! @see client::async_call
+    template <typename... Args>
+    auto async_call(std::string_view name, Args&&... args)
+    {
+        return select()->async_call(name, std::forward<Args>(args)...);
+    }
+
+    //! Call a remote procedure prepared with @ref client::prepare
+    //! using one of the clients
+    //! @see client::async_call
+    template <typename... Args>
+    auto async_call(const prepared_request_type& request, Args&&... args)
+    {
+        return select()->async_call(request, std::forward<Args>(args)...);
+    }
+
+    //! Call a remote procedure and convert its result using one of the clients
+    //! @see client::async_call_as
+    template <typename R, typename Method, typename... Args>
+    auto async_call_as(const Method& method, Args&&... args)
+    {
+        return select()->template async_call_as<R>(
+            method, std::forward<Args>(args)...);
+    }
+
+private:
+    static std::uint64_t mix(std::uint64_t x)
+    {
+        // splitmix64 finalizer
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    class initiate_async_connect {
+    public:
+        using executor_type = typename client_pool::executor_type;
+
+        explicit initiate_async_connect(client_pool* self) : self_(self) {}
+
+        executor_type get_executor() const noexcept
+        {
+            return self_->get_executor();
+        }
+
+        template <typename ConnectHandler, typename EndpointSequence>
+        void operator()(
+            ConnectHandler&& handler,
+            const EndpointSequence& endpoints) const
+        {
+            PACKIO_STATIC_ASSERT_TRAIT(ConnectHandler);
+
+            assert(std::begin(endpoints) != std::end(endpoints));
+
+            using handler_type = std::decay_t<ConnectHandler>;
+            using handler_executor_type =
+                net::associated_executor_t<handler_type, executor_type>;
+            struct state {
+                state(
+                    handler_type handler,
+                    handler_executor_type executor,
+                    std::size_t remaining)
+                    : handler{std::move(handler)},
+                      work{std::move(executor)},
+                      remaining{remaining}
+                {
+                }
+
+                std::mutex mutex;
+                handler_type handler;
+                // keeps the executor of the handler busy until completion
+                net::executor_work_guard<handler_executor_type> work;
+                std::size_t remaining;
+                error_code ec;
+            };
+            auto executor = net::get_associated_executor(
+                handler, self_->get_executor());
+            auto shared_state = std::make_shared<state>(
+                std::forward<ConnectHandler>(handler), executor, self_->size());
+
+            auto it = std::begin(endpoints);
+            for (auto& client : self_->clients_) {
+                if (it == std::end(endpoints)) {
+                    it = std::begin(endpoints);
+                }
+                PACKIO_DEBUG("pool connecting client");
+                client->socket().async_connect(
+                    *it++, [shared_state](error_code ec) {
+                        std::unique_lock lock{shared_state->mutex};
+                        if (ec) {
+                            PACKIO_WARN("connect error: {}", ec.message());
+                            if (!shared_state->ec) {
+                                shared_state->ec = ec;
+                            }
+                        }
+                        if (--shared_state->remaining == 0) {
+                            lock.unlock();
+                            // complete on the executor of the handler, not
+                            // on the executor of the last client connected
+                            net::dispatch(
+                                shared_state->work.get_executor(),
+                                [shared_state]() {
+                                    auto ec = shared_state->ec;
+                                    std::move(shared_state->handler)(ec);
+                                });
+                        }
+                    });
+            }
+        }
+
+    private:
+        client_pool* self_;
+    };
+
+    std::vector<std::shared_ptr<client_type>> clients_;
+    balancing_policy policy_{balancing_policy::power_of_two_choices};
+    std::atomic<std::uint64_t> counter_{0};
+};
+
+//! Create a client pool
+//! @tparam Rpc RPC protocol implementation
+//! @tparam Socket Socket type to use for the clients
+//! @tparam Map Container used by the clients to associate call IDs and handlers
+//! @param context The executor or execution context used to create the sockets
+//! @param size The number of clients in the pool
+template <
+    typename Rpc,
+    typename Socket,
+    template <class...> class Map = default_map,
+    typename ExecutorOrContext>
+auto make_client_pool(ExecutorOrContext&& context, std::size_t size)
+{
+    std::vector<std::shared_ptr<client<Rpc, Socket, Map>>> clients;
+    clients.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        clients.push_back(
+            std::make_shared<client<Rpc, Socket, Map>>(Socket{context}));
+    }
+    return std::make_shared<client_pool<Rpc, Socket, Map>>(std::move(clients));
+}
+
+} // packio
+
+#endif // PACKIO_CLIENT_POOL_H
@@ -8,7 +8,12 @@
 //! @file
 //! Class @ref packio::dispatcher "dispatcher"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -18,13 +23,29 @@
 #include "args_specs.h"
 #include "handler.h"
 #include "internal/config.h"
+#include "internal/memo_cache.h"
+#include "internal/metrics.h"
 #include "internal/movable_function.h"
+#include "internal/perfect_hash.h"
+#include "internal/rcu.h"
 #include "internal/rpc.h"
+#include "internal/token_bucket.h"
 #include "internal/utils.h"
 #include "traits.h"
 
 namespace packio {
 
+//! Priority classes of the procedures, see dispatcher::set_priority
+enum class priority_class : unsigned char {
+    high, //!< Overtakes other procedures, e.g. health checks
+    normal, //!< The default priority
+    low, //!< Overtaken by other procedures, e.g. bulk work
+};
+
+//! The number of priority classes
+constexpr std::size_t kPriorityClasses =
+    static_cast<std::size_t>(priority_class::low) + 1;
+
 //! The dispatcher class, used to store and dispatch procedures
 //! @tparam Rpc RPC protocol implementation
 //! @tparam Map The container used to associate procedures to their name
@@ -41,8 +62,85 @@ public:
     //! The type of function stored in the dispatcher
     using function_type = internal::movable_function<
         void(completion_handler<rpc_type>, args_type&& args)>;
-    //! A shared pointer to @ref function_type
-    using function_ptr_type = std::shared_ptr<function_type>;
+
+    //! A procedure stored in the dispatcher
+    class procedure_type : public function_type {
+    public:
+        explicit procedure_type(
+            function_type&& fct,
+            std::optional<internal::any_io_executor> executor = std::nullopt,
+            bool is_inline = false)
+            : function_type{std::move(fct)},
+              executor_{std::move(executor)},
+              is_inline_{is_inline}
+        {
+        }
+
+        //! Get the executor the procedure runs on, if any
+        const std::optional<internal::any_io_executor>& executor() const noexcept
+        {
+            return executor_;
+        }
+
+        //! Check if the procedure runs on the read strand, see @ref add_inline
+        bool is_inline() const noexcept { return is_inline_; }
+
+        //! Get the priority of the procedure, see @ref set_priority
+        priority_class priority() const noexcept
+        {
+            return priority_.load(std::memory_order_relaxed);
+        }
+
+        //! Get the rate limit of the procedure, see @ref set_rate_limit
+        internal::token_bucket& rate_limit() const noexcept
+        {
+            return rate_limit_;
+        }
+
+        //! Get the cache of the results of the procedure, null if it is
+        //! not idempotent, see @ref set_idempotent
+        std::shared_ptr<internal::memo_cache> memo() const
+        {
+            if (!is_idempotent_.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            return memo_;
+        }
+
+#if PACKIO_HAS_METRICS
+        //! Get the metrics of the procedure, null if it is not measured,
+        //! see @ref set_metrics_enabled
+        const std::shared_ptr<internal::procedure_metrics>& metrics() const noexcept
+        {
+            return metrics_;
+        }
+#endif // PACKIO_HAS_METRICS
+
+    private:
+        friend class dispatcher;
+
+        std::optional<internal::any_io_executor> executor_;
+        bool is_inline_;
+        std::atomic<priority_class> priority_{priority_class::normal};
+        mutable internal::token_bucket rate_limit_;
+        // written once, before is_idempotent_ is set
+        std::shared_ptr<internal::memo_cache> memo_;
+        std::atomic<bool> is_idempotent_{false};
+#if PACKIO_HAS_METRICS
+        std::shared_ptr<internal::procedure_metrics> metrics_;
+#endif // PACKIO_HAS_METRICS
+    };
+
+    //! A shared pointer to @ref procedure_type
+    using function_ptr_type = std::shared_ptr<procedure_type>;
+
+private:
+    using function_map_type = Map<std::string, function_ptr_type>;
+    using snapshot_guard_type =
+        typename internal::rcu<function_map_type>::reader_guard;
+    using frozen_map_type = internal::perfect_hash_map<function_ptr_type>;
+
+public:
 
     //! Add a synchronous procedure to the dispatcher
     //! @param name The name of the procedure
@@ -55,13 +153,10 @@ public:
         SyncProcedure&& fct)
     {
         PACKIO_STATIC_ASSERT_TRAIT(SyncProcedure);
-        std::unique_lock lock{map_mutex_};
-        return function_map_
-            .emplace(
-                name,
-                std::make_shared<function_type>(wrap_sync(
-                    std::forward<SyncProcedure>(fct), std::move(arg_specs))))
-            .second;
+        return insert(
+            name,
+            std::make_shared<procedure_type>(wrap_sync(
+                std::forward<SyncProcedure>(fct), std::move(arg_specs))));
     }
 
     //! @overload
@@ -71,6 +166,111 @@ public:
         return add<SyncProcedure>(name, {}, std::forward<SyncProcedure>(fct));
     }
 
+    //! Add a synchronous procedure executed by an executor
+    //!
+    //! The procedure is posted to this executor instead of the executor
+    //! of the session, use it to run blocking or CPU-intensive procedures
+    //! out of the threads reading the sockets.
+    //! @param name The name of the procedure
+    //! @param executor The executor used to execute the procedure
+    //! @param arg_specs The argument specifications (optional)
+    //! @param fct The procedure itself
+    template <
+        typename Executor,
+        typename SyncProcedure,
+        typename = std::enable_if_t<internal::is_executor_v<Executor>>>
+    bool add(
+        std::string_view name,
+        const Executor& executor,
+        args_specs<SyncProcedure> arg_specs,
+        SyncProcedure&& fct)
+    {
+        PACKIO_STATIC_ASSERT_TRAIT(SyncProcedure);
+        return insert(
+            name,
+            std::make_shared<procedure_type>(
+                wrap_sync(
+                    std::forward<SyncProcedure>(fct), std::move(arg_specs)),
+                internal::any_io_executor{executor}));
+    }
+
+    //! @overload
+    template <
+        typename Executor,
+        typename SyncProcedure,
+        typename = std::enable_if_t<internal::is_executor_v<Executor>>>
+    bool add(std::string_view name, const Executor& executor, SyncProcedure&& fct)
+    {
+        return add<Executor, SyncProcedure>(
+            name, executor, {}, std::forward<SyncProcedure>(fct));
+    }
+
+    //! @overload
+    template <
+        typename ExecutionContext,
+        typename SyncProcedure,
+        typename = std::enable_if_t<internal::is_execution_context_v<ExecutionContext>>>
+    bool add(
+        std::string_view name,
+        ExecutionContext& ctx,
+        args_specs<SyncProcedure> arg_specs,
+        SyncProcedure&& fct)
+    {
+        return add(
+            name,
+            ctx.get_executor(),
+            std::move(arg_specs),
+            std::forward<SyncProcedure>(fct));
+    }
+
+    //! @overload
+    template <
+        typename ExecutionContext,
+        typename SyncProcedure,
+        typename = std::enable_if_t<internal::is_execution_context_v<ExecutionContext>>>
+    bool add(std::string_view name, ExecutionContext& ctx, SyncProcedure&& fct)
+    {
+        return add(
+            name,
+            ctx.get_executor(),
+            args_specs<SyncProcedure>{},
+            std::forward<SyncProcedure>(fct));
+    }
+
+    //! Add a synchronous procedure executed inline
+    //!
+    //! The procedure is executed directly on the strand reading the
+    //! requests of the session, instead of being posted to the executor,
+    //! and its response is written with the other responses of the read.
+    //! No request of the session is read while it runs: use it for short,
+    //! non-blocking procedures only.
+    //! @param name The name of the procedure
+    //! @param arg_specs The argument specifications (optional)
+    //! @param fct The procedure itself
+    template <typename SyncProcedure>
+    bool add_inline(
+        std::string_view name,
+        args_specs<SyncProcedure> arg_specs,
+        SyncProcedure&& fct)
+    {
+        PACKIO_STATIC_ASSERT_TRAIT(SyncProcedure);
+        return insert(
+            name,
+            std::make_shared<procedure_type>(
+                wrap_sync(
+                    std::forward<SyncProcedure>(fct), std::move(arg_specs)),
+                std::nullopt,
+                true));
+    }
+
+    //! @overload
+    template <typename SyncProcedure>
+    bool add_inline(std::string_view name, SyncProcedure&& fct)
+    {
+        return add_inline<SyncProcedure>(
+            name, {}, std::forward<SyncProcedure>(fct));
+    }
+
     //! Add an asynchronous procedure to the dispatcher
     //! @param name The name of the procedure
     //! @param arg_specs The argument specifications (optional)
@@ -82,13 +282,10 @@ public:
         AsyncProcedure&& fct)
     {
         PACKIO_STATIC_ASSERT_TTRAIT(AsyncProcedure, rpc_type);
-        std::unique_lock lock{map_mutex_};
-        return function_map_
-            .emplace(
-                name,
-                std::make_shared<function_type>(wrap_async(
-                    std::forward<AsyncProcedure>(fct), std::move(arg_specs))))
-            .second;
+        return insert(
+            name,
+            std::make_shared<procedure_type>(wrap_async(
+                std::forward<AsyncProcedure>(fct), std::move(arg_specs))));
     }
 
     //! @overload
@@ -99,6 +296,82 @@ public:
             name, {}, std::forward<AsyncProcedure>(fct));
     }
 
+    //! Add an asynchronous procedure executed by an executor
+    //!
+    //! The procedure is posted to this executor instead of the executor
+    //! of the session.
+    //! @param name The name of the procedure
+    //! @param executor The executor used to execute the procedure
+    //! @param arg_specs The argument specifications (optional)
+    //! @param fct The procedure itself
+    template <
+        typename Executor,
+        typename AsyncProcedure,
+        typename = std::enable_if_t<internal::is_executor_v<Executor>>>
+    bool add_async(
+        std::string_view name,
+        const Executor& executor,
+        args_specs<AsyncProcedure> arg_specs,
+        AsyncProcedure&& fct)
+    {
+        PACKIO_STATIC_ASSERT_TTRAIT(AsyncProcedure, rpc_type);
+        return insert(
+            name,
+            std::make_shared<procedure_type>(
+                wrap_async(
+                    std::forward<AsyncProcedure>(fct), std::move(arg_specs)),
+                internal::any_io_executor{executor}));
+    }
+
+    //! @overload
+    template <
+        typename Executor,
+        typename AsyncProcedure,
+        typename = std::enable_if_t<internal::is_executor_v<Executor>>>
+    bool add_async(
+        std::string_view name,
+        const Executor& executor,
+        AsyncProcedure&& fct)
+    {
+        return add_async<Executor, AsyncProcedure>(
+            name, executor, {}, std::forward<AsyncProcedure>(fct));
+    }
+
+    //! @overload
+    template <
+        typename ExecutionContext,
+        typename AsyncProcedure,
+        typename = std::enable_if_t<internal::is_execution_context_v<ExecutionContext>>>
+    bool add_async(
+        std::string_view name,
+        ExecutionContext& ctx,
+        args_specs<AsyncProcedure> arg_specs,
+        AsyncProcedure&& fct)
+    {
+        return add_async(
+            name,
+            ctx.get_executor(),
+            std::move(arg_specs),
+            std::forward<AsyncProcedure>(fct));
+    }
+
+    //! @overload
+    template <
+        typename ExecutionContext,
+        typename AsyncProcedure,
+        typename = std::enable_if_t<internal::is_execution_context_v<ExecutionContext>>>
+    bool add_async(
+        std::string_view name,
+        ExecutionContext& ctx,
+        AsyncProcedure&& fct)
+    {
+        return add_async(
+            name,
+            ctx.get_executor(),
+            args_specs<AsyncProcedure>{},
+            std::forward<AsyncProcedure>(fct));
+    }
+
 #if defined(PACKIO_HAS_CO_AWAIT)
     //! Add a coroutine to the dispatcher
     //! @param name The name of the procedure
@@ -116,15 +389,12 @@ public:
         CoroProcedure&& coro)
     {
         PACKIO_STATIC_ASSERT_TRAIT(CoroProcedure);
-        std::unique_lock lock{map_mutex_};
-        return function_map_
-            .emplace(
-                name,
-                std::make_shared<function_type>(wrap_coro(
-                    executor,
-                    std::forward<CoroProcedure>(coro),
-                    std::move(arg_specs))))
-            .second;
+        return insert(
+            name,
+            std::make_shared<procedure_type>(wrap_coro(
+                executor,
+                std::forward<CoroProcedure>(coro),
+                std::move(arg_specs))));
     }
 
     //! @overload
@@ -168,7 +438,14 @@ public:
     bool remove(const std::string& name)
     {
         std::unique_lock lock{map_mutex_};
-        return function_map_.erase(name);
+        if (is_frozen()) {
+            return false;
+        }
+        bool removed = function_map_.erase(name);
+        if (removed) {
+            update_snapshot();
+        }
+        return removed;
     }
 
     //! Check if a procedure is registered
@@ -185,8 +462,12 @@ public:
     size_t clear()
     {
         std::unique_lock lock{map_mutex_};
+        if (is_frozen()) {
+            return 0;
+        }
         size_t size = function_map_.size();
         function_map_.clear();
+        update_snapshot();
         return size;
     }
 
@@ -207,6 +488,297 @@ public:
         return names;
     }
 
+    //! Set the priority of a procedure
+    //!
+    //! Requests are executed by order of priority when the server
+    //! schedules them by priority, see server::set_priority_scheduling.
+    //! Inline procedures and procedures running on their own executor
+    //! are not scheduled. Can be changed at any time, also once the
+    //! dispatcher is frozen.
+    //! @param name The name of the procedure
+    //! @param priority The priority class of the procedure
+    //! @return True if the procedure was found
+    bool set_priority(const std::string& name, priority_class priority)
+    {
+        std::unique_lock lock{map_mutex_};
+        auto it = function_map_.find(name);
+        if (it == function_map_.end()) {
+            return false;
+        }
+        it->second->priority_.store(priority, std::memory_order_relaxed);
+        return true;
+    }
+
+    //! Limit the rate of the calls to a procedure
+    //!
+    //! The calls of all sessions share a token bucket refilled at the
+    //! given rate. Calls made when the bucket is empty are answered with
+    //! an error immediately, without being dispatched. Can be changed at
+    //! any time, also once the dispatcher is frozen.
+    //! @param name The name of the procedure
+    //! @param rate The number of calls allowed per second, zero disables the limit
+    //! @param burst The number of calls allowed at once
+    //! @return True if the procedure was found
+    bool set_rate_limit(const std::string& name, double rate, std::size_t burst = 1)
+    {
+        std::unique_lock lock{map_mutex_};
+        auto it = function_map_.find(name);
+        if (it == function_map_.end()) {
+            return false;
+        }
+        it->second->rate_limit_.set_rate(rate, burst);
+        return true;
+    }
+
+    //! Mark a procedure as idempotent and cacheable
+    //!
+    //! Calls of the procedure with the same serialized arguments are
+    //! collapsed: while a call executes, identical calls wait for its
+    //! result instead of executing the procedure again, and receive the
+    //! same result, or the same error if the call fails. Successful
+    //! results are then cached for the time to live, already serialized;
+    //! errors are never cached.
+    //! Can only be set once per procedure, also once the dispatcher is
+    //! frozen.
+    //! @param name The name of the procedure
+    //! @param ttl The time to live of the results, zero to only collapse
+    //! concurrent calls
+    //! @param max_entries The maximum number of results cached
+    //! @return True if the procedure was found and was not already idempotent
+    bool set_idempotent(
+        const std::string& name,
+        std::chrono::steady_clock::duration ttl = {},
+        std::size_t max_entries = 1024)
+    {
+        std::unique_lock lock{map_mutex_};
+        auto it = function_map_.find(name);
+        if (it == function_map_.end() || it->second->memo_) {
+            return false;
+        }
+        it->second->memo_ =
+            std::make_shared<internal::memo_cache>(ttl, max_entries);
+        it->second->is_idempotent_.store(true, std::memory_order_release);
+        return true;
+    }
+
+    //! Enable or disable the read-mostly mode
+    //!
+    //! In read-mostly mode, an immutable copy of the procedure map is
+    //! published on each modification, and @ref find looks procedures up
+    //! in it without locking the mutex nor copying the shared pointer of
+    //! the procedure. Use it when procedures are rarely added or removed
+    //! once the server runs: each modification copies the map.
+    //! @param enabled True to enable the read-mostly mode
+    void set_read_mostly(bool enabled)
+    {
+        std::unique_lock lock{map_mutex_};
+        read_mostly_.store(enabled, std::memory_order_release);
+        update_snapshot();
+    }
+
+    //! Check if the read-mostly mode is enabled, see @ref set_read_mostly
+    bool get_read_mostly() const
+    {
+        return read_mostly_.load(std::memory_order_acquire);
+    }
+
+#if PACKIO_HAS_METRICS
+    //! Enable or disable the metrics of the procedures
+    //!
+    //! The procedures added while metrics are enabled record their
+    //! calls, errors and latencies, see @ref metrics. Recording is
+    //! lock-free and each hardware thread updates its own copy of the
+    //! metrics, see internal::metrics_shards. Define
+    //! PACKIO_HAS_METRICS to 0 to compile the metrics out.
+    //! @param enabled True to measure the procedures added from now on
+    void set_metrics_enabled(bool enabled)
+    {
+        std::unique_lock lock{map_mutex_};
+        metrics_enabled_ = enabled;
+    }
+
+    //! Check if the metrics are enabled, see @ref set_metrics_enabled
+    bool get_metrics_enabled() const
+    {
+        std::unique_lock lock{map_mutex_};
+        return metrics_enabled_;
+    }
+
+    //! Get the metrics of the measured procedures, ordered by name
+    //! @return A snapshot of the metrics of each measured procedure
+    std::vector<procedure_metrics_snapshot> metrics() const
+    {
+        std::unique_lock lock{map_mutex_};
+        std::vector<procedure_metrics_snapshot> snapshots;
+        for (const auto& [name, procedure] : function_map_) {
+            if (procedure->metrics_) {
+                snapshots.push_back(procedure->metrics_->snapshot(name));
+            }
+        }
+        std::sort(snapshots.begin(), snapshots.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.name < rhs.name;
+        });
+        return snapshots;
+    }
+#endif // PACKIO_HAS_METRICS
+
+    //! A reference to a procedure returned by @ref find
+    //!
+    //! The procedure is kept alive by the reference, even if it is removed
+    //! from the dispatcher in the meantime.
+    class procedure_ref {
+    public:
+        procedure_ref() = default;
+
+        explicit operator bool() const noexcept { return ptr_ != nullptr; }
+        const procedure_type& operator*() const noexcept { return *ptr_; }
+        const procedure_type* operator->() const noexcept { return ptr_; }
+
+    private:
+        friend class dispatcher;
+
+        explicit procedure_ref(function_ptr_type owner)
+            : ptr_{owner.get()}, owner_{std::move(owner)}
+        {
+        }
+
+        procedure_ref(const procedure_type* ptr, snapshot_guard_type guard)
+            : ptr_{ptr}, guard_{std::move(guard)}
+        {
+        }
+
+        const procedure_type* ptr_{nullptr};
+        function_ptr_type owner_;
+        snapshot_guard_type guard_;
+    };
+
+    //! Name of the procedure listing the numeric method IDs, see @ref freeze
+    static constexpr std::string_view kMethodIdsProcedure =
+        internal::kMethodIdsProcedure;
+
+    //! Freeze the dispatcher
+    //!
+    //! Procedures can no longer be added or removed once the dispatcher
+    //! is frozen. @ref find then looks procedures up in a perfect hash
+    //! table, without locking nor allocating, and procedures are not
+    //! reference-counted anymore: they live as long as the dispatcher.
+    //!
+    //! Freezing also assigns a numeric ID to each procedure, that clients
+    //! can send instead of the procedure name. The IDs are listed by the
+    //! procedure named @ref kMethodIdsProcedure, added by this function,
+    //! which returns a map from procedure names to IDs. The low 32 bits
+    //! of an ID are the position of the procedure in the sorted list of
+    //! names, the high 32 bits are a hash of this list: an ID fetched
+    //! from a dispatcher with other procedures is rejected.
+    //! @return True if the dispatcher is frozen, False if a procedure
+    //! is registered under the reserved name @ref kMethodIdsProcedure
+    bool freeze()
+    {
+        std::unique_lock lock{map_mutex_};
+        if (is_frozen()) {
+            return true;
+        }
+        if (function_map_.find(std::string{kMethodIdsProcedure})
+            != function_map_.end()) {
+            return false;
+        }
+
+        std::vector<std::string> names;
+        names.reserve(function_map_.size() + 1);
+        for (const auto& [name, procedure] : function_map_) {
+            names.push_back(name);
+        }
+        names.emplace_back(kMethodIdsProcedure);
+        std::sort(names.begin(), names.end());
+
+        // FNV-1a of the sorted names, null terminators included
+        std::uint32_t hash = 2166136261u;
+        for (const auto& name : names) {
+            for (std::size_t i = 0; i <= name.size(); ++i) {
+                hash ^= static_cast<unsigned char>(name.c_str()[i]);
+                hash *= 16777619u;
+            }
+        }
+        ids_hash_ = hash;
+
+        std::map<std::string, std::uint64_t> ids;
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            ids.emplace(names[i], (std::uint64_t{hash} << 32) | i);
+        }
+        auto method_ids = std::make_shared<procedure_type>(
+            wrap_sync([ids] { return ids; }, {}), std::nullopt, true);
+        enable_metrics(*method_ids);
+        function_map_.emplace(kMethodIdsProcedure, std::move(method_ids));
+
+        procedures_by_id_.reserve(names.size());
+        for (const auto& name : names) {
+            procedures_by_id_.push_back(function_map_.find(name)->second);
+        }
+        std::vector<std::pair<std::string, function_ptr_type>> entries{
+            function_map_.begin(), function_map_.end()};
+        frozen_map_ = std::make_unique<const frozen_map_type>(std::move(entries));
+        frozen_.store(true, std::memory_order_release);
+        return true;
+    }
+
+    //! Check if the dispatcher is frozen, see @ref freeze
+    bool is_frozen() const { return frozen_.load(std::memory_order_acquire); }
+
+    //! Find a procedure
+    //!
+    //! Lock-free in read-mostly mode, see @ref set_read_mostly, and
+    //! allocation-free once frozen, see @ref freeze.
+    //! @param name The name of the procedure
+    //! @return A reference to the procedure, empty if it is not found
+    procedure_ref find(std::string_view name) const
+    {
+        if (is_frozen()) {
+            return find_frozen(name);
+        }
+        return find(std::string{name});
+    }
+
+    //! Find a procedure by numeric ID, see @ref freeze
+    //! @param id The numeric ID of the procedure
+    //! @return A reference to the procedure, empty if the dispatcher is
+    //! not frozen or the ID is unknown
+    procedure_ref find_id(std::uint64_t id) const
+    {
+        if (!is_frozen() || (id >> 32) != ids_hash_) {
+            return {};
+        }
+        auto index = id & 0xffffffffu;
+        if (index >= procedures_by_id_.size()) {
+            return {};
+        }
+        return {procedures_by_id_[index].get(), snapshot_guard_type{}};
+    }
+
+    //! @overload
+    procedure_ref find(const char* name) const
+    {
+        return find(std::string_view{name});
+    }
+
+    //! @overload
+    procedure_ref find(const std::string& name) const
+    {
+        if (is_frozen()) {
+            return find_frozen(name);
+        }
+        if (read_mostly_.load(std::memory_order_acquire)) {
+            auto [snapshot, guard] = snapshot_.read();
+            if (snapshot) {
+                auto it = snapshot->find(name);
+                if (it == snapshot->end()) {
+                    return {};
+                }
+                return {it->second.get(), std::move(guard)};
+            }
+        }
+        return procedure_ref{get(name)};
+    }
+
     function_ptr_type get(const std::string& name) const
     {
         std::unique_lock lock{map_mutex_};
@@ -220,7 +792,49 @@ public:
     }
 
 private:
-    using function_map_type = Map<std::string, function_ptr_type>;
+    bool insert(std::string_view name, function_ptr_type procedure)
+    {
+        std::unique_lock lock{map_mutex_};
+        if (is_frozen()) {
+            return false;
+        }
+        enable_metrics(*procedure);
+        bool inserted = function_map_.emplace(name, std::move(procedure)).second;
+        if (inserted) {
+            update_snapshot();
+        }
+        return inserted;
+    }
+
+    void enable_metrics(procedure_type& procedure)
+    {
+#if PACKIO_HAS_METRICS
+        if (metrics_enabled_) {
+            procedure.metrics_ = std::make_shared<internal::procedure_metrics>();
+        }
+#else // PACKIO_HAS_METRICS
+        (void)procedure;
+#endif // PACKIO_HAS_METRICS
+    }
+
+    procedure_ref find_frozen(std::string_view name) const
+    {
+        auto procedure = frozen_map_->find(name);
+        if (!procedure) {
+            return {};
+        }
+        return {procedure->get(), snapshot_guard_type{}};
+    }
+
+    void update_snapshot()
+    {
+        if (read_mostly_.load(std::memory_order_relaxed)) {
+            snapshot_.publish(std::make_unique<const function_map_type>(function_map_));
+        }
+        else {
+            snapshot_.publish(nullptr);
+        }
+    }
 
     template <typename F>
     auto wrap_sync(F&& fct, args_specs<F> args_specs)
@@ -323,6 +937,15 @@ private:
 
     mutable mutex_type map_mutex_;
     function_map_type function_map_;
+    std::atomic<bool> read_mostly_{false};
+    internal::rcu<function_map_type> snapshot_;
+    std::atomic<bool> frozen_{false};
+    std::unique_ptr<const frozen_map_type> frozen_map_;
+    std::vector<function_ptr_type> procedures_by_id_;
+    std::uint32_t ids_hash_{0};
+#if PACKIO_HAS_METRICS
+    bool metrics_enabled_{false};
+#endif // PACKIO_HAS_METRICS
 };
 
 } // packio
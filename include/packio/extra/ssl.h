@@ -44,6 +44,9 @@ public:
         return this->lowest_layer().close(std::forward<Args>(args)...);
     }
 
+    //! Reads cannot be interrupted by cancel
+    static constexpr bool kCancellable = false;
+
     //! Cancel is not possible on websockets, raise a compile-time error is the
     //! user tries to use it.
     template <typename... Args>
@@ -54,6 +54,9 @@ public:
             std::forward<Args>(args)...);
     }
 
+    //! Reads cannot be interrupted by cancel
+    static constexpr bool kCancellable = false;
+
     //! Cancel is not possible on websockets, raise a compile-time error is the
     //! user tries to use it.
     template <typename... Args>
@@ -9,6 +9,11 @@
 //! Class @ref packio::completion_handler "completion_handler"
 
 #include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
 #include "internal/config.h"
 #include "internal/rpc.h"
@@ -29,11 +34,16 @@ public:
     using id_type = typename Rpc::id_type;
     using response_buffer_type =
         decltype(Rpc::serialize_response(std::declval<id_type>()));
-    using function_type = std::function<void(response_buffer_type&&)>;
+    //! The handler called with the response and true if it is an error
+    using function_type = std::function<void(response_buffer_type&&, bool)>;
+    //! The handler called with the serialized result and true if it is
+    //! an error, see @ref share_result
+    using result_handler_type =
+        std::function<void(std::shared_ptr<const std::string>, bool)>;
 
     template <typename F>
     completion_handler(const id_type& id, F&& handler)
-        : id_(id), handler_(std::forward<F>(handler))
+        : id_(id), handler_(wrap(std::forward<F>(handler)))
     {
     }
 
@@ -49,10 +59,13 @@ public:
     completion_handler& operator=(const completion_handler&) = delete;
 
     //! Move constructor
-    completion_handler(completion_handler&& other)
-        : id_(other.id_), handler_(std::move(other.handler_))
+    completion_handler(completion_handler&& other) noexcept
+        : id_(std::move(other.id_)),
+          handler_(std::move(other.handler_)),
+          result_handler_(std::move(other.result_handler_))
     {
         other.handler_ = nullptr;
+        other.result_handler_ = nullptr;
     }
 
     //! Move assignment operator
@@ -63,7 +76,9 @@ public:
         }
         id_ = other.id_;
         handler_ = std::move(other.handler_);
+        result_handler_ = std::move(other.result_handler_);
         other.handler_ = nullptr;
+        other.result_handler_ = nullptr;
         return *this;
     }
 
@@ -72,25 +87,67 @@ public:
     template <typename T>
     void set_value(T&& return_value)
     {
-        complete(Rpc::serialize_response(id_, std::forward<T>(return_value)));
+        if (result_handler_) {
+            share(Rpc::serialize_result(std::forward<T>(return_value)), false);
+            return;
+        }
+        complete(
+            Rpc::serialize_response(id_, std::forward<T>(return_value)), false);
     }
 
     //! @overload
-    void set_value() { complete(Rpc::serialize_response(id_)); }
+    void set_value()
+    {
+        if (result_handler_) {
+            share(Rpc::serialize_result(typename Rpc::native_type{}), false);
+            return;
+        }
+        complete(Rpc::serialize_response(id_), false);
+    }
+
+    //! Notify successful completion of the procedure with a result
+    //! serialized by Rpc::serialize_result
+    //! @param result The serialized result
+    void set_serialized_value(std::string_view result)
+    {
+        complete(Rpc::serialize_serialized_response(id_, result), false);
+    }
+
+    //! Notify erroneous completion of the procedure with an error
+    //! serialized by Rpc::serialize_error
+    //! @param error The serialized error
+    void set_serialized_error(std::string_view error)
+    {
+        complete(Rpc::serialize_serialized_response(id_, error, true), true);
+    }
+
+    //! Share the result of the procedure
+    //!
+    //! The result, or the error, is serialized once by
+    //! Rpc::serialize_result, or Rpc::serialize_error, passed to the
+    //! handler and used for the response.
+    //! @param handler The handler called with the serialized result
+    void share_result(result_handler_type handler)
+    {
+        result_handler_ = std::move(handler);
+    }
 
     //! Notify erroneous completion of the procedure with an associated error
     //! @param error_value Error value
     template <typename T>
     void set_error(T&& error_value)
     {
-        complete(Rpc::serialize_error_response(id_, std::forward<T>(error_value)));
+        if (result_handler_) {
+            share(Rpc::serialize_error(std::forward<T>(error_value)), true);
+            return;
+        }
+        complete(
+            Rpc::serialize_error_response(id_, std::forward<T>(error_value)),
+            true);
     }
 
     //! @overload
-    void set_error()
-    {
-        complete(Rpc::serialize_error_response(id_, "unknown error"));
-    }
+    void set_error() { set_error("unknown error"); }
 
     //! Same as @ref set_value
     template <typename T>
@@ -103,14 +160,37 @@ public:
     void operator()() { set_value(); }
 
 private:
-    void complete(response_buffer_type&& buffer)
+    template <typename F>
+    static function_type wrap(F&& handler)
+    {
+        if constexpr (std::is_invocable_v<F&, response_buffer_type&&, bool>) {
+            return std::forward<F>(handler);
+        }
+        else {
+            // handlers not interested in the error status
+            return [handler = std::forward<F>(handler)](
+                       response_buffer_type&& buffer, bool) mutable {
+                handler(std::move(buffer));
+            };
+        }
+    }
+
+    void share(std::string&& serialized, bool error)
+    {
+        auto result = std::make_shared<const std::string>(std::move(serialized));
+        std::exchange(result_handler_, nullptr)(result, error);
+        complete(Rpc::serialize_serialized_response(id_, *result, error), error);
+    }
+
+    void complete(response_buffer_type&& buffer, bool error)
     {
-        handler_(std::move(buffer));
+        handler_(std::move(buffer), error);
         handler_ = nullptr;
     }
 
     id_type id_;
     function_type handler_;
+    result_handler_type result_handler_;
 };
 
 template <typename>
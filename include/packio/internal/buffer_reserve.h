@@ -0,0 +1,93 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_BUFFER_RESERVE_H
+#define PACKIO_BUFFER_RESERVE_H
+
+#include <algorithm>
+#include <cstddef>
+
+namespace packio {
+namespace internal {
+
+//! Size reserved by a reception buffer before each read
+//!
+//! The size adapts to the recent reads: it doubles after a read that
+//! fills the reservation, so a large message needs a logarithmic number
+//! of reads, and halves after consecutive reads that use less than half
+//! of it, so a burst of large messages does not keep the buffer large:
+//! its owner releases the grown capacity when the size decreases.
+//! The size stays between a minimum and a maximum, adaptation is
+//! disabled when the maximum is not larger than the minimum.
+class buffer_reserve {
+public:
+    //! Number of consecutive small reads after which the size decreases
+    static constexpr std::size_t kShrinkThreshold = 2;
+
+    buffer_reserve(std::size_t min, std::size_t max)
+        : min_{min}, max_{max}, size_{min}
+    {
+    }
+
+    void set_min(std::size_t min) noexcept
+    {
+        min_ = min;
+        reset();
+    }
+    std::size_t get_min() const noexcept { return min_; }
+
+    void set_max(std::size_t max) noexcept
+    {
+        max_ = max;
+        reset();
+    }
+    std::size_t get_max() const noexcept { return max_; }
+
+    //! Size to reserve before the next read
+    std::size_t size() const noexcept { return size_; }
+
+    //! Update the size with the length of a completed read
+    //!
+    //! Return true when the size decreased, the owner of the buffer
+    //! can then release the capacity grown for larger reads.
+    bool on_read(std::size_t length) noexcept
+    {
+        if (max_ <= min_) {
+            return false;
+        }
+
+        if (length >= size_) {
+            size_ = std::min(max_, size_ * 2);
+            small_reads_ = 0;
+        }
+        else if (length >= size_ / 2) {
+            small_reads_ = 0;
+        }
+        else if (++small_reads_ >= kShrinkThreshold) {
+            auto previous = size_;
+            size_ = std::max(min_, size_ / 2);
+            small_reads_ = 0;
+            return size_ < previous;
+        }
+        return false;
+    }
+
+    //! Restart from the minimum size
+    void reset() noexcept
+    {
+        size_ = min_;
+        small_reads_ = 0;
+    }
+
+private:
+    std::size_t min_;
+    std::size_t max_;
+    std::size_t size_;
+    std::size_t small_reads_{0};
+};
+
+} // internal
+} // packio
+
+#endif // PACKIO_BUFFER_RESERVE_H
@@ -0,0 +1,91 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_CODEL_H
+#define PACKIO_CODEL_H
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+
+namespace packio {
+namespace internal {
+
+//! Load shedding based on the time requests spend in a queue (CoDel)
+//!
+//! The controller tracks the minimum queueing delay over each interval.
+//! When it stayed above the target for a whole interval, the queue is
+//! standing, not absorbing a burst: requests that waited longer than
+//! the target are shed until an interval goes by with a delay below the
+//! target. Otherwise, only requests that waited longer than the interval
+//! are shed. Shedding the oldest requests first keeps the queue short
+//! and the requests still served are served in time.
+//! Thread-safe, requests of all threads share the same controller.
+class codel {
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    codel(clock_type::duration target, clock_type::duration interval)
+        : target_{target},
+          interval_{interval},
+          interval_end_{(clock_type::now() + interval).time_since_epoch().count()}
+    {
+    }
+
+    clock_type::duration target() const noexcept { return target_; }
+    clock_type::duration interval() const noexcept { return interval_; }
+
+    //! Check if the request has been queued for too long
+    //! @param sojourn The time the request spent in the queue
+    //! @param now The time the request left the queue
+    bool should_shed(clock_type::duration sojourn, clock_type::time_point now) noexcept
+    {
+        auto delay = sojourn.count();
+        auto min_delay = min_delay_.load(std::memory_order_relaxed);
+        while (delay < min_delay
+               && !min_delay_.compare_exchange_weak(
+                   min_delay, delay, std::memory_order_relaxed)) {
+        }
+
+        // a single thread closes each interval
+        auto interval_end = interval_end_.load(std::memory_order_relaxed);
+        if (now.time_since_epoch().count() >= interval_end
+            && interval_end_.compare_exchange_strong(
+                interval_end,
+                (now + interval_).time_since_epoch().count(),
+                std::memory_order_relaxed)) {
+            auto interval_min = min_delay_.exchange(
+                kNoDelay, std::memory_order_relaxed);
+            overloaded_.store(
+                interval_min != kNoDelay && interval_min > target_.count(),
+                std::memory_order_relaxed);
+        }
+
+        if (overloaded_.load(std::memory_order_relaxed)) {
+            return sojourn > target_;
+        }
+        return sojourn > interval_;
+    }
+
+    //! Check if the queueing delay stayed above the target for the last interval
+    bool overloaded() const noexcept
+    {
+        return overloaded_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr clock_type::rep kNoDelay =
+        std::numeric_limits<clock_type::rep>::max();
+
+    const clock_type::duration target_;
+    const clock_type::duration interval_;
+    std::atomic<clock_type::rep> interval_end_;
+    std::atomic<clock_type::rep> min_delay_{kNoDelay};
+    std::atomic<bool> overloaded_{false};
+};
+
+} // internal
+} // packio
+
+#endif // PACKIO_CODEL_H
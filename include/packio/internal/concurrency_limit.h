@@ -0,0 +1,133 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_CONCURRENCY_LIMIT_H
+#define PACKIO_CONCURRENCY_LIMIT_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+namespace packio {
+namespace internal {
+
+//! Limit of the number of calls in flight
+//!
+//! The limit is either fixed or adapted to the round-trip time of the
+//! calls with an AIMD policy: it grows by one per window of calls
+//! completed in time, and shrinks by a constant ratio when a call takes
+//! longer than a multiple of the minimum round-trip time, or times out.
+//! The limit shrinks at most once per window, calls initiated before
+//! the last decrease do not decrease it further. Not thread-safe, except
+//! @ref limit which can be read from any thread.
+class concurrency_limit {
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    //! The ratio applied to the limit when it decreases
+    static constexpr double kBackoffRatio = 0.9;
+    //! Calls slower than this multiple of the minimum round-trip time
+    //! decrease the limit
+    static constexpr double kLatencyTolerance = 2.0;
+    //! Number of calls after which the minimum round-trip time is measured again
+    static constexpr std::size_t kRttWindowSize = 1000;
+
+    //! Set the maximum number of calls in flight, zero disables the limit
+    void set_max(std::size_t max) noexcept
+    {
+        max_ = max;
+        limit_ = static_cast<double>(max);
+        publish();
+    }
+    std::size_t get_max() const noexcept { return max_; }
+
+    void set_adaptive(bool adaptive) noexcept
+    {
+        adaptive_ = adaptive;
+        publish();
+    }
+    bool get_adaptive() const noexcept { return adaptive_; }
+
+    bool enabled() const noexcept { return max_ > 0; }
+
+    //! Current maximum number of calls in flight
+    std::size_t limit() const noexcept
+    {
+        return published_.load(std::memory_order_relaxed);
+    }
+
+    //! Update the limit with a completed call
+    //! @param rtt The round-trip time of the call
+    //! @param timed_out Whether the call timed out
+    //! @param in_flight Number of calls still in flight
+    //! @param now The current time
+    void on_complete(
+        clock_type::duration rtt,
+        bool timed_out,
+        std::size_t in_flight,
+        clock_type::time_point now)
+    {
+        if (!adaptive_) {
+            return;
+        }
+
+        update_min_rtt(rtt);
+        const auto tolerated = std::chrono::duration_cast<clock_type::duration>(
+            min_rtt_ * kLatencyTolerance);
+        if (timed_out || rtt > tolerated) {
+            if (now - rtt >= last_decrease_) {
+                limit_ = std::max(1.0, limit_ * kBackoffRatio);
+                last_decrease_ = now;
+                publish();
+            }
+            return;
+        }
+
+        // only grow when the limit is actually used
+        if (2 * (in_flight + 1) >= limit()) {
+            limit_ = std::min(static_cast<double>(max_), limit_ + 1.0 / limit_);
+            publish();
+        }
+    }
+
+private:
+    void publish() noexcept
+    {
+        // a disabled limit has no lower bound of one call
+        auto limit = adaptive_ && enabled()
+                         ? std::clamp<std::size_t>(
+                             static_cast<std::size_t>(limit_), 1, max_)
+                         : max_;
+        published_.store(limit, std::memory_order_relaxed);
+    }
+
+    void update_min_rtt(clock_type::duration rtt)
+    {
+        window_min_rtt_ = std::min(window_min_rtt_, rtt);
+        if (samples_ == 0 || rtt < min_rtt_) {
+            min_rtt_ = rtt;
+        }
+        if (++samples_ % kRttWindowSize == 0) {
+            // follow the round-trip time when the path gets slower
+            min_rtt_ = window_min_rtt_;
+            window_min_rtt_ = clock_type::duration::max();
+        }
+    }
+
+    std::size_t max_{0};
+    bool adaptive_{false};
+    double limit_{0};
+    std::atomic<std::size_t> published_{0};
+
+    std::size_t samples_{0};
+    clock_type::duration min_rtt_{clock_type::duration::zero()};
+    clock_type::duration window_min_rtt_{clock_type::duration::max()};
+    clock_type::time_point last_decrease_{};
+};
+
+} // internal
+} // packio
+
+#endif // PACKIO_CONCURRENCY_LIMIT_H
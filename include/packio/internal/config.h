@@ -21,6 +21,11 @@
 #define PACKIO_HAS_BOOST_JSON __has_include(<boost/json.hpp>)
 #endif // !defined(PACKIO_HAS_BOOST_JSON)
 
+#if !defined(PACKIO_HAS_METRICS)
+// Define to 0 to compile out the collection of metrics
+#define PACKIO_HAS_METRICS 1
+#endif // !defined(PACKIO_HAS_METRICS)
+
 #if !defined(PACKIO_STANDALONE_ASIO)
 // If we cannot find boost but we can find asio, fallback to it
 #define PACKIO_STANDALONE_ASIO (!__has_include(<boost/asio.hpp>) && __has_include(<asio.hpp>))
@@ -0,0 +1,102 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_HISTOGRAM_H
+#define PACKIO_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace packio {
+namespace internal {
+
+//! Layout of the buckets of a @ref histogram
+//!
+//! Values below kSubBuckets have their own bucket, then each power of
+//! two is divided in kSubBuckets buckets of equal width, as HDR
+//! histograms do: the relative error is bounded by 1 / kSubBuckets.
+//! Values from 2^kMaxBits are counted in the last bucket.
+struct histogram_layout {
+    static constexpr unsigned kSubBucketBits = 3;
+    static constexpr std::uint64_t kSubBuckets = 1u << kSubBucketBits;
+    static constexpr unsigned kMaxBits = 40;
+    static constexpr std::size_t kBuckets =
+        (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+    static std::size_t index(std::uint64_t value) noexcept
+    {
+        if (value < kSubBuckets) {
+            return static_cast<std::size_t>(value);
+        }
+        unsigned msb = 63;
+        while (!(value >> msb)) {
+            --msb;
+        }
+        if (msb >= kMaxBits) {
+            return kBuckets - 1;
+        }
+        auto shift = msb - kSubBucketBits;
+        auto top = value >> shift;
+        return static_cast<std::size_t>((shift + 1) * kSubBuckets + top - kSubBuckets);
+    }
+
+    //! Smallest value counted in a bucket
+    static std::uint64_t lower_bound(std::size_t index) noexcept
+    {
+        if (index < kSubBuckets) {
+            return index;
+        }
+        auto group = index / kSubBuckets;
+        auto top = index % kSubBuckets + kSubBuckets;
+        return top << (group - 1);
+    }
+
+    //! Largest value counted in a bucket
+    static std::uint64_t upper_bound(std::size_t index) noexcept
+    {
+        if (index < kSubBuckets) {
+            return index;
+        }
+        return lower_bound(index) + (std::uint64_t{1} << (index / kSubBuckets - 1)) - 1;
+    }
+};
+
+//! Histogram recorded concurrently with relaxed atomic increments
+class histogram {
+public:
+    void record(std::uint64_t value) noexcept
+    {
+        buckets_[histogram_layout::index(value)].fetch_add(
+            1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    //! Add the content of the histogram to counts, count and sum
+    void merge_into(
+        std::vector<std::uint64_t>& counts,
+        std::uint64_t& count,
+        std::uint64_t& sum) const noexcept
+    {
+        counts.resize(histogram_layout::kBuckets);
+        for (std::size_t i = 0; i < histogram_layout::kBuckets; ++i) {
+            counts[i] += buckets_[i].load(std::memory_order_relaxed);
+        }
+        count += count_.load(std::memory_order_relaxed);
+        sum += sum_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, histogram_layout::kBuckets> buckets_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> sum_{0};
+};
+
+} // internal
+} // packio
+
+#endif // PACKIO_HISTOGRAM_H
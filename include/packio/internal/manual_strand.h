@@ -5,54 +5,152 @@
 #ifndef PACKIO_MANUAL_STRAND_H
 #define PACKIO_MANUAL_STRAND_H
 
-#include <queue>
+#include <deque>
+#include <memory>
+#include <vector>
 
 #include "config.h"
 #include "movable_function.h"
+#include "utils.h"
 
 namespace packio {
 namespace internal {
 
-template <typename Executor>
+//! Serialize writes on a stream
+//!
+//! Buffers pushed while a write is in flight are queued, and gathered
+//! into a single scatter-gather write when the write completes.
+template <typename Stream>
 class manual_strand {
 public:
-    using function_type = movable_function<void()>;
+    using executor_type = typename Stream::executor_type;
+    using handler_type = movable_function<void(error_code, std::size_t)>;
 
-    explicit manual_strand(net::strand<Executor>& strand) : strand_{strand} {}
+    //! The default maximum number of bytes gathered in a single write
+    static constexpr std::size_t kDefaultMaxWriteSize = 65536;
+    //! The default maximum number of buffers gathered in a single write
+    static constexpr std::size_t kDefaultMaxWriteBuffers = 64;
 
-    void push(function_type function)
+    manual_strand(Stream& stream, net::strand<executor_type>& strand)
+        : stream_{stream}, strand_{strand}
     {
-        net::dispatch(strand_, [this, function = std::move(function)]() mutable {
-            queue_.push(std::move(function));
+    }
+
+    //! Queue a buffer for writing
+    //!
+    //! The memory referenced by buffer must stay valid until handler
+    //! is called, the handler is usually the owner of this memory.
+    void push(net::const_buffer buffer, handler_type handler)
+    {
+        net::dispatch(
+            strand_,
+            [this, buffer, handler = std::move(handler)]() mutable {
+                queue_.push_back({buffer, std::move(handler)});
+
+                if (!executing_ && !corked_) {
+                    executing_ = true;
+                    execute();
+                }
+            });
+    }
+
+    //! Hold the buffers pushed from the strand until @ref uncork
+    //!
+    //! Buffers produced in a row are then gathered in the same write.
+    void cork()
+    {
+        assert(strand_.running_in_this_thread());
+        corked_ = true;
+    }
+
+    //! Write the buffers held since @ref cork
+    void uncork()
+    {
+        assert(strand_.running_in_this_thread());
+        corked_ = false;
+        if (!executing_) {
+            executing_ = true;
+            execute();
+        }
+    }
 
-            if (!executing_) {
-                executing_ = true;
-                execute();
-            }
-        });
+    void set_max_write_size(std::size_t size) noexcept
+    {
+        max_write_size_ = size;
     }
+    std::size_t get_max_write_size() const noexcept { return max_write_size_; }
 
-    void next()
+    void set_max_write_buffers(std::size_t count) noexcept
     {
-        net::dispatch(strand_, [this] { execute(); });
+        max_write_buffers_ = count;
+    }
+    std::size_t get_max_write_buffers() const noexcept
+    {
+        return max_write_buffers_;
     }
 
 private:
+    struct entry {
+        net::const_buffer buffer;
+        handler_type handler;
+    };
+
     void execute()
     {
+        assert(strand_.running_in_this_thread());
         if (queue_.empty()) {
             executing_ = false;
             return;
         }
 
-        auto function = std::move(queue_.front());
-        queue_.pop();
-        function();
+        // always write at least one buffer, even if it exceeds the limits
+        std::size_t size = 0;
+        buffers_.clear();
+        do {
+            size += queue_.front().buffer.size();
+            buffers_.push_back(queue_.front().buffer);
+            writing_.push_back(std::move(queue_.front()));
+            queue_.pop_front();
+        } while (!queue_.empty() && buffers_.size() < max_write_buffers_
+                 && size + queue_.front().buffer.size() <= max_write_size_);
+
+        PACKIO_TRACE("write {} buffer(s), {} bytes", buffers_.size(), size);
+        net::async_write(
+            stream_,
+            buffers_,
+            internal::bind_executor(
+                strand_,
+                [this](error_code ec, std::size_t) {
+                    std::vector<entry> batch;
+                    batch.swap(writing_);
+                    writing_.swap(spare_);
+                    execute();
+                    for (auto& entry : batch) {
+                        entry.handler(ec, ec ? 0 : entry.buffer.size());
+                    }
+
+                    // handlers may own the last reference to the owner
+                    // of this strand, only recycle the storage if the
+                    // strand survives their destruction
+                    std::weak_ptr<bool> alive = alive_;
+                    batch.clear();
+                    if (!alive.expired()) {
+                        spare_.swap(batch);
+                    }
+                }));
     }
 
-    net::strand<Executor>& strand_;
-    std::queue<function_type> queue_;
+    Stream& stream_;
+    net::strand<executor_type>& strand_;
+    std::deque<entry> queue_;
+    std::vector<net::const_buffer> buffers_;
+    std::vector<entry> writing_;
+    std::vector<entry> spare_;
+    std::shared_ptr<bool> alive_{std::make_shared<bool>(true)};
     bool executing_{false};
+    bool corked_{false};
+    std::size_t max_write_size_{kDefaultMaxWriteSize};
+    std::size_t max_write_buffers_{kDefaultMaxWriteBuffers};
 };
 
 } // internal
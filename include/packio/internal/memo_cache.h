@@ -0,0 +1,188 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_MEMO_CACHE_H
+#define PACKIO_MEMO_CACHE_H
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "movable_function.h"
+
+namespace packio {
+namespace internal {
+
+//! Shares the results of an idempotent procedure between identical calls
+//!
+//! Calls are identified by a key, their serialized arguments. The first
+//! call of a key executes the procedure, the identical calls received
+//! until it completes wait for its result instead of executing the
+//! procedure again, also when it fails: they receive the same error.
+//! Successful results are then cached for a time to live, zero to only
+//! share results between concurrent calls; errors are never cached.
+//! Results are stored serialized, so that they are serialized once for
+//! all the calls they answer. Thread-safe.
+class memo_cache {
+public:
+    using clock_type = std::chrono::steady_clock;
+    //! A serialized result or error
+    using result_type = std::shared_ptr<const std::string>;
+    //! Called with the serialized result and true if it is an error
+    using waiter_type = movable_function<void(result_type, bool)>;
+
+    //! Outcome of a lookup
+    struct lookup_result {
+        //! The cached result, if any
+        result_type cached;
+        //! True if the caller must execute the procedure and call
+        //! @ref complete, false if it found a result or is waiting for one
+        bool leader{false};
+    };
+
+    //! Create a cache
+    //! @param ttl The time to live of the results, zero to disable caching
+    //! @param max_entries The maximum number of results cached
+    memo_cache(clock_type::duration ttl, std::size_t max_entries)
+        : ttl_{ttl}, max_entries_{max_entries}
+    {
+    }
+
+    memo_cache(const memo_cache&) = delete;
+    memo_cache& operator=(const memo_cache&) = delete;
+
+    clock_type::duration ttl() const noexcept { return ttl_; }
+    std::size_t max_entries() const noexcept { return max_entries_; }
+
+    //! Look for the result of a call
+    //! @param key The key of the call
+    //! @param make_waiter Called if an identical call is in progress, returns
+    //! the @ref waiter_type called with its result
+    //! @param now The current time
+    template <typename MakeWaiter>
+    lookup_result lookup(
+        const std::string& key,
+        MakeWaiter&& make_waiter,
+        clock_type::time_point now = clock_type::now())
+    {
+        std::unique_lock lock{mutex_};
+        auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            entries_.emplace(key, entry{});
+            return {nullptr, true};
+        }
+
+        auto& entry = it->second;
+        if (entry.in_flight) {
+            entry.waiters.push_back(make_waiter());
+            return {nullptr, false};
+        }
+        if (entry.result && now < entry.expiry) {
+            return {entry.result, false};
+        }
+        // expired
+        --cached_;
+        entry = {};
+        return {nullptr, true};
+    }
+
+    //! Publish the result of a call, after a lookup returned leader
+    //! @param key The key of the call
+    //! @param result The serialized result or error
+    //! @param error True if the call failed, the error is not cached
+    //! @param now The current time
+    void complete(
+        const std::string& key,
+        result_type result,
+        bool error,
+        clock_type::time_point now = clock_type::now())
+    {
+        std::vector<waiter_type> waiters;
+        {
+            std::unique_lock lock{mutex_};
+            evict_expired(now);
+            auto it = entries_.find(key);
+            if (it == entries_.end()) {
+                return;
+            }
+            waiters = std::move(it->second.waiters);
+            if (!error && ttl_ > clock_type::duration::zero()
+                && cached_ < max_entries_) {
+                it->second = {result, now + ttl_, false, {}};
+                ++cached_;
+                expiries_.emplace_back(now + ttl_, key);
+            }
+            else {
+                entries_.erase(it);
+            }
+        }
+        for (auto& waiter : waiters) {
+            waiter(result, error);
+        }
+    }
+
+    //! Get the number of calls waiting for an identical call
+    std::size_t waiting() const
+    {
+        std::unique_lock lock{mutex_};
+        std::size_t waiting = 0;
+        for (const auto& [key, entry] : entries_) {
+            waiting += entry.waiters.size();
+        }
+        return waiting;
+    }
+
+    //! Get the number of results cached, including the expired ones
+    std::size_t size() const
+    {
+        std::unique_lock lock{mutex_};
+        return cached_;
+    }
+
+private:
+    struct entry {
+        result_type result;
+        clock_type::time_point expiry;
+        bool in_flight{true};
+        std::vector<waiter_type> waiters;
+    };
+
+    //! Remove the expired results
+    //!
+    //! Results are cached with the same time to live, so they expire in
+    //! the order they were cached: only the front of expiries_ is checked.
+    void evict_expired(clock_type::time_point now)
+    {
+        while (!expiries_.empty() && expiries_.front().first <= now) {
+            const auto& [expiry, key] = expiries_.front();
+            auto it = entries_.find(key);
+            // the result may have been removed or replaced since
+            if (it != entries_.end() && !it->second.in_flight
+                && it->second.expiry == expiry) {
+                entries_.erase(it);
+                --cached_;
+            }
+            expiries_.pop_front();
+        }
+    }
+
+    const clock_type::duration ttl_;
+    const std::size_t max_entries_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, entry> entries_;
+    //! Expiry and key of the cached results, in the order they were cached
+    std::deque<std::pair<clock_type::time_point, std::string>> expiries_;
+    std::size_t cached_{0};
+};
+
+} // internal
+} // packio
+
+#endif // PACKIO_MEMO_CACHE_H
@@ -0,0 +1,285 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_INTERNAL_METRICS_H
+#define PACKIO_INTERNAL_METRICS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../metrics.h"
+#include "config.h"
+#include "histogram.h"
+
+namespace packio {
+namespace internal {
+
+#if PACKIO_HAS_METRICS
+
+//! Maximum number of copies of the metrics
+constexpr std::size_t kMaxMetricsShards = 64;
+
+//! Get the number of copies of the metrics: the number of hardware
+//! threads rounded up to a power of two, at most kMaxMetricsShards
+inline std::size_t metrics_shards() noexcept
+{
+    static const std::size_t shards = [] {
+        std::size_t threads =
+            std::max(1u, std::thread::hardware_concurrency());
+        std::size_t shards = 1;
+        while (shards < threads && shards < kMaxMetricsShards) {
+            shards <<= 1;
+        }
+        return shards;
+    }();
+    return shards;
+}
+
+//! Get the copy of the metrics updated by the calling thread
+//!
+//! Threads are assigned copies in turn, so each thread has its own copy
+//! as long as there are no more threads than hardware threads.
+inline std::size_t metrics_shard() noexcept
+{
+    static std::atomic<std::size_t> next_shard{0};
+    thread_local const std::size_t shard =
+        next_shard.fetch_add(1, std::memory_order_relaxed)
+        & (metrics_shards() - 1);
+    return shard;
+}
+
+inline std::uint64_t to_nanoseconds(std::chrono::steady_clock::duration duration) noexcept
+{
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    return ns > 0 ? static_cast<std::uint64_t>(ns) : 0;
+}
+
+//! Traffic counters of a session
+struct session_metrics {
+    std::atomic<std::uint64_t> bytes_in{0};
+    std::atomic<std::uint64_t> bytes_out{0};
+    std::atomic<std::uint64_t> messages_in{0};
+    std::atomic<std::uint64_t> messages_out{0};
+
+    void add_to(session_metrics_snapshot& snapshot) const noexcept
+    {
+        snapshot.bytes_in += bytes_in.load(std::memory_order_relaxed);
+        snapshot.bytes_out += bytes_out.load(std::memory_order_relaxed);
+        snapshot.messages_in += messages_in.load(std::memory_order_relaxed);
+        snapshot.messages_out += messages_out.load(std::memory_order_relaxed);
+    }
+};
+
+//! Traffic counters of all the sessions of a server, sharded by thread
+class sharded_session_metrics {
+public:
+    session_metrics& local() noexcept { return shards_[metrics_shard()].metrics; }
+
+    session_metrics_snapshot snapshot() const noexcept
+    {
+        session_metrics_snapshot snapshot;
+        for (std::size_t i = 0; i < metrics_shards(); ++i) {
+            shards_[i].metrics.add_to(snapshot);
+        }
+        return snapshot;
+    }
+
+private:
+    struct alignas(64) shard_type {
+        session_metrics metrics;
+    };
+
+    std::unique_ptr<shard_type[]> shards_{new shard_type[metrics_shards()]()};
+};
+
+//! Calls and latencies of a procedure, sharded by thread
+//!
+//! A shard holds three histograms, about 7KB, so shards are allocated
+//! by the first call recorded on them: a procedure only costs the
+//! shards of the threads that actually ran it.
+class procedure_metrics {
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    procedure_metrics() = default;
+    procedure_metrics(const procedure_metrics&) = delete;
+    procedure_metrics& operator=(const procedure_metrics&) = delete;
+
+    ~procedure_metrics()
+    {
+        for (std::size_t i = 0; i < metrics_shards(); ++i) {
+            delete shards_[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    void record_call(
+        clock_type::duration queue_time,
+        clock_type::duration execution_time,
+        bool error) noexcept
+    {
+        auto& shard = local_shard();
+        shard.calls.fetch_add(1, std::memory_order_relaxed);
+        if (error) {
+            shard.errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        shard.queue_time.record(to_nanoseconds(queue_time));
+        shard.execution_time.record(to_nanoseconds(execution_time));
+    }
+
+    void record_write(clock_type::duration write_time) noexcept
+    {
+        local_shard().write_time.record(to_nanoseconds(write_time));
+    }
+
+    procedure_metrics_snapshot snapshot(std::string name) const
+    {
+        procedure_metrics_snapshot snapshot;
+        snapshot.name = std::move(name);
+        for (std::size_t i = 0; i < metrics_shards(); ++i) {
+            const auto* shard_ptr = shards_[i].load(std::memory_order_acquire);
+            if (!shard_ptr) {
+                continue;
+            }
+            const auto& shard = *shard_ptr;
+            snapshot.calls += shard.calls.load(std::memory_order_relaxed);
+            snapshot.errors += shard.errors.load(std::memory_order_relaxed);
+            shard.queue_time.merge_into(
+                snapshot.queue_time.buckets,
+                snapshot.queue_time.count,
+                snapshot.queue_time.sum);
+            shard.execution_time.merge_into(
+                snapshot.execution_time.buckets,
+                snapshot.execution_time.count,
+                snapshot.execution_time.sum);
+            shard.write_time.merge_into(
+                snapshot.write_time.buckets,
+                snapshot.write_time.count,
+                snapshot.write_time.sum);
+        }
+        return snapshot;
+    }
+
+private:
+    struct alignas(64) shard_type {
+        std::atomic<std::uint64_t> calls{0};
+        std::atomic<std::uint64_t> errors{0};
+        histogram queue_time;
+        histogram execution_time;
+        histogram write_time;
+    };
+
+    shard_type& local_shard() noexcept
+    {
+        auto& slot = shards_[metrics_shard()];
+        auto* shard = slot.load(std::memory_order_acquire);
+        if (!shard) {
+            // threads sharing the slot may race, only one shard is kept
+            auto created = std::make_unique<shard_type>();
+            if (slot.compare_exchange_strong(
+                    shard,
+                    created.get(),
+                    std::memory_order_acq_rel,
+                    std::memory_order_acquire)) {
+                shard = created.release();
+            }
+        }
+        return *shard;
+    }
+
+    std::unique_ptr<std::atomic<shard_type*>[]> shards_{
+        new std::atomic<shard_type*>[metrics_shards()]()};
+};
+
+//! Measures a call, from the reception of its request to the write of
+//! its response, for the metrics of its procedure
+class call_metrics {
+public:
+    using clock_type = procedure_metrics::clock_type;
+
+    call_metrics() = default;
+
+    //! Start measuring a call, its request has just been received
+    explicit call_metrics(std::shared_ptr<procedure_metrics> metrics)
+        : metrics_{std::move(metrics)}, received_{clock_type::now()}
+    {
+    }
+
+    //! The procedure starts
+    void start() noexcept
+    {
+        if (metrics_) {
+            started_ = clock_type::now();
+        }
+    }
+
+    //! The procedure completed
+    void complete(bool error) noexcept
+    {
+        if (metrics_) {
+            completed_ = clock_type::now();
+            metrics_->record_call(started_ - received_, completed_ - started_, error);
+        }
+    }
+
+    //! The response has been written
+    void written() noexcept
+    {
+        if (metrics_) {
+            metrics_->record_write(clock_type::now() - completed_);
+        }
+    }
+
+private:
+    std::shared_ptr<procedure_metrics> metrics_;
+    clock_type::time_point received_;
+    clock_type::time_point started_;
+    clock_type::time_point completed_;
+};
+
+//! Measures the calls of a batch, written at once
+class batch_call_metrics {
+public:
+    //! A call of the batch completed
+    void add(call_metrics&& metrics) { calls_.push_back(std::move(metrics)); }
+
+    //! The response of the batch has been written
+    void written() noexcept
+    {
+        for (auto& call : calls_) {
+            call.written();
+        }
+    }
+
+private:
+    std::vector<call_metrics> calls_;
+};
+
+#else // PACKIO_HAS_METRICS
+
+class call_metrics {
+public:
+    void start() noexcept {}
+    void complete(bool) noexcept {}
+    void written() noexcept {}
+};
+
+class batch_call_metrics {
+public:
+    void add(call_metrics&&) noexcept {}
+    void written() noexcept {}
+};
+
+#endif // PACKIO_HAS_METRICS
+
+} // internal
+} // packio
+
+#endif // PACKIO_INTERNAL_METRICS_H
@@ -5,88 +5,184 @@
 #ifndef PACKIO_UNIQUE_FUNCTION_H
 #define PACKIO_UNIQUE_FUNCTION_H
 
+#include <cstddef>
 #include <functional>
+#include <new>
 #include <type_traits>
 #include <utility>
 
+//! Default size of the inline storage of @ref packio::internal::movable_function
+//!
+//! Fits the callables of the hot paths: the handler of a call made with
+//! use_future wrapped by the in-flight limit of the client, and a
+//! completion handler waiting for an identical call on the server.
+#define PACKIO_MOVABLE_FUNCTION_DEFAULT_INLINE_SIZE (10 * sizeof(void*))
+
+#if !defined(PACKIO_MOVABLE_FUNCTION_INLINE_SIZE)
+//! Size of the inline storage of @ref packio::internal::movable_function
+#define PACKIO_MOVABLE_FUNCTION_INLINE_SIZE PACKIO_MOVABLE_FUNCTION_DEFAULT_INLINE_SIZE
+#endif // !defined(PACKIO_MOVABLE_FUNCTION_INLINE_SIZE)
+
 namespace packio {
 namespace internal {
 
-template <typename T>
-class movable_function : public std::function<T> {
-    template <typename Fn, typename En = void>
-    struct wrapper {
-    };
+template <typename T, std::size_t InlineSize = PACKIO_MOVABLE_FUNCTION_INLINE_SIZE>
+class movable_function;
 
-    // specialization for CopyConstructible Fn
+//! Move-only type-erased callable
+//!
+//! Callables that fit in InlineSize bytes and are nothrow move constructible
+//! are stored inline, larger ones are allocated on the heap.
+template <typename R, typename... Args, std::size_t InlineSize>
+class movable_function<R(Args...), InlineSize> {
     template <typename Fn>
-    struct wrapper<Fn, std::enable_if_t<std::is_copy_constructible<Fn>::value>> {
-        Fn fn;
+    using enable_if_callable_t = std::enable_if_t<
+        !std::is_same_v<std::decay_t<Fn>, movable_function>
+        && !std::is_same_v<std::decay_t<Fn>, std::nullptr_t>
+        && std::is_invocable_r_v<R, std::decay_t<Fn>&, Args...>>;
 
-        template <typename... Args>
-        auto operator()(Args&&... args)
-        {
-            return fn(std::forward<Args>(args)...);
-        }
-    };
+public:
+    //! Size of the inline storage
+    static constexpr std::size_t inline_size = InlineSize;
 
-    // specialization for MoveConstructible-only Fn
+    //! Check if a callable of type Fn is stored without allocation
     template <typename Fn>
-    struct wrapper<
-        Fn,
-        std::enable_if_t<
-            !std::is_copy_constructible<Fn>::value
-            && std::is_move_constructible<Fn>::value>> {
-        Fn fn;
+    static constexpr bool is_stored_inline_v = sizeof(Fn) <= InlineSize
+        && alignof(Fn) <= alignof(std::max_align_t)
+        && std::is_nothrow_move_constructible_v<Fn>;
 
-        wrapper(Fn&& fn) : fn(std::forward<Fn>(fn)) {}
-
-        wrapper(wrapper&&) = default;
-        wrapper& operator=(wrapper&&) = default;
+    movable_function() noexcept = default;
+    movable_function(std::nullptr_t) noexcept {}
 
-        // these two functions are instantiated by std::function and are never called
-        wrapper(const wrapper& rhs) : fn(const_cast<Fn&&>(rhs.fn))
-        {
-            // hack to initialize fn for non-DefaultContructible types
-            std::abort();
+    template <typename Fn, typename = enable_if_callable_t<Fn>>
+    movable_function(Fn&& fn)
+    {
+        using fn_type = std::decay_t<Fn>;
+        if constexpr (is_stored_inline_v<fn_type>) {
+            ::new (static_cast<void*>(storage_)) fn_type(std::forward<Fn>(fn));
         }
-        wrapper& operator=(wrapper&) { std::abort(); }
-
-        template <typename... Args>
-        auto operator()(Args&&... args)
-        {
-            return fn(std::forward<Args>(args)...);
+        else {
+            ::new (static_cast<void*>(storage_))
+                fn_type*(new fn_type(std::forward<Fn>(fn)));
         }
-    };
+        ops_ = &operations<fn_type>::value;
+    }
 
-    using base = std::function<T>;
+    movable_function(movable_function&& other) noexcept
+    {
+        move_from(other);
+    }
 
-public:
-    movable_function() noexcept = default;
-    movable_function(std::nullptr_t) noexcept : base(nullptr) {}
+    movable_function& operator=(movable_function&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
 
-    template <typename Fn>
-    movable_function(Fn&& f) : base(wrapper<Fn>{std::forward<Fn>(f)})
+    movable_function& operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    template <typename Fn, typename = enable_if_callable_t<Fn>>
+    movable_function& operator=(Fn&& fn)
     {
+        return *this = movable_function{std::forward<Fn>(fn)};
     }
 
-    movable_function(movable_function&&) = default;
-    movable_function& operator=(movable_function&&) = default;
+    movable_function(const movable_function&) = delete;
+    movable_function& operator=(const movable_function&) = delete;
 
-    movable_function& operator=(std::nullptr_t)
+    ~movable_function() { reset(); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    R operator()(Args... args) const
     {
-        base::operator=(nullptr);
-        return *this;
+        if (!ops_) {
+            throw std::bad_function_call{};
+        }
+        return ops_->invoke(storage_, std::forward<Args>(args)...);
     }
 
+private:
+    struct operations_type {
+        R (*invoke)(void* storage, Args&&... args);
+        // move the callable from src to dst and destroy src
+        void (*relocate)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
     template <typename Fn>
-    movable_function& operator=(Fn&& f)
+    struct operations {
+        static Fn& get(void* storage) noexcept
+        {
+            if constexpr (is_stored_inline_v<Fn>) {
+                return *std::launder(static_cast<Fn*>(storage));
+            }
+            else {
+                return **std::launder(static_cast<Fn**>(storage));
+            }
+        }
+
+        static R invoke(void* storage, Args&&... args)
+        {
+            if constexpr (std::is_void_v<R>) {
+                std::invoke(get(storage), std::forward<Args>(args)...);
+            }
+            else {
+                return std::invoke(get(storage), std::forward<Args>(args)...);
+            }
+        }
+
+        static void relocate(void* dst, void* src) noexcept
+        {
+            if constexpr (is_stored_inline_v<Fn>) {
+                Fn& fn = get(src);
+                ::new (dst) Fn(std::move(fn));
+                fn.~Fn();
+            }
+            else {
+                ::new (dst) Fn*(&get(src));
+            }
+        }
+
+        static void destroy(void* storage) noexcept
+        {
+            if constexpr (is_stored_inline_v<Fn>) {
+                get(storage).~Fn();
+            }
+            else {
+                delete &get(storage);
+            }
+        }
+
+        static constexpr operations_type value{&invoke, &relocate, &destroy};
+    };
+
+    void move_from(movable_function& other) noexcept
     {
-        base::operator=(wrapper<Fn>{std::forward<Fn>(f)});
-        return *this;
+        if (other.ops_) {
+            other.ops_->relocate(storage_, other.storage_);
+            ops_ = std::exchange(other.ops_, nullptr);
+        }
+    }
+
+    void reset() noexcept
+    {
+        if (ops_) {
+            std::exchange(ops_, nullptr)->destroy(storage_);
+        }
     }
 
-    using base::operator();
+    static_assert(InlineSize >= sizeof(void*), "inline storage is too small");
+
+    alignas(std::max_align_t) mutable unsigned char storage_[InlineSize];
+    const operations_type* ops_{nullptr};
 };
 
 } // internal
@@ -0,0 +1,130 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_PENDING_CALLS_H
+#define PACKIO_PENDING_CALLS_H
+
+#include <cstdint>
+#include <vector>
+
+namespace packio {
+namespace internal {
+
+//! Table of the handlers of pending calls, indexed by call ID
+//!
+//! Call IDs are generated sequentially, so the handlers are stored in
+//! a power-of-two slot array indexed by the low bits of the ID. The
+//! array only grows when it is dense. A call that outlives many more
+//! recent calls is evicted to the overflow map instead, so a single
+//! long-lived call does not force the array to grow.
+template <typename Handler, template <class...> class Map>
+class pending_calls {
+public:
+    using sequence_type = std::uint64_t;
+
+    //! The initial number of slots
+    static constexpr std::size_t kInitialCapacity = 64;
+
+    bool empty() const noexcept { return size() == 0; }
+    std::size_t size() const noexcept { return used_ + overflow_.size(); }
+
+    void insert(sequence_type seq, Handler handler)
+    {
+        if (slots_.empty()) {
+            slots_.resize(kInitialCapacity);
+        }
+
+        while (true) {
+            auto& slot = slots_[seq & (slots_.size() - 1)];
+            if (!slot.handler) {
+                slot.seq = seq;
+                slot.handler = std::move(handler);
+                ++used_;
+                return;
+            }
+
+            if (2 * used_ >= slots_.size()) {
+                grow();
+                continue;
+            }
+
+            // the table is sparse, the slot is held by a long-lived call
+            overflow_.emplace(slot.seq, std::move(slot.handler));
+            slot.handler = nullptr;
+            --used_;
+        }
+    }
+
+    //! Remove and return the handler associated with seq
+    //! @return The handler, or a null handler if seq is unknown
+    Handler take(sequence_type seq)
+    {
+        if (!slots_.empty()) {
+            auto& slot = slots_[seq & (slots_.size() - 1)];
+            if (slot.handler && slot.seq == seq) {
+                auto handler = std::move(slot.handler);
+                slot.handler = nullptr;
+                --used_;
+                return handler;
+            }
+        }
+
+        if (!overflow_.empty()) {
+            auto it = overflow_.find(seq);
+            if (it != overflow_.end()) {
+                auto handler = std::move(it->second);
+                overflow_.erase(it);
+                return handler;
+            }
+        }
+        return nullptr;
+    }
+
+    //! Remove and return all the handlers
+    std::vector<Handler> take_all()
+    {
+        std::vector<Handler> handlers;
+        handlers.reserve(size());
+        for (auto& slot : slots_) {
+            if (slot.handler) {
+                handlers.push_back(std::move(slot.handler));
+                slot.handler = nullptr;
+            }
+        }
+        for (auto& pair : overflow_) {
+            handlers.push_back(std::move(pair.second));
+        }
+        overflow_.clear();
+        used_ = 0;
+        return handlers;
+    }
+
+private:
+    struct slot {
+        sequence_type seq{0};
+        Handler handler;
+    };
+
+    void grow()
+    {
+        std::vector<slot> slots(2 * slots_.size());
+        for (auto& slot : slots_) {
+            if (slot.handler) {
+                // no collision possible: entries sharing the low bits
+                // of the new mask also share the low bits of the old one
+                slots[slot.seq & (slots.size() - 1)] = std::move(slot);
+            }
+        }
+        slots_ = std::move(slots);
+    }
+
+    std::vector<slot> slots_;
+    std::size_t used_{0};
+    Map<sequence_type, Handler> overflow_;
+};
+
+} // internal
+} // packio
+
+#endif // PACKIO_PENDING_CALLS_H
@@ -0,0 +1,165 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_PERFECT_HASH_H
+#define PACKIO_PERFECT_HASH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace packio {
+namespace internal {
+
+//! Immutable map from names to values, indexed by a perfect hash
+//!
+//! Names are first hashed into buckets, then each bucket gets a seed
+//! that sends all its names to distinct free slots, the largest buckets
+//! being placed first. A lookup hashes the name once, mixes the hash
+//! with the seed of its bucket and compares the name stored in the
+//! slot: it never allocates and never probes.
+template <typename T>
+class perfect_hash_map {
+public:
+    //! Build the map, names must be unique
+    explicit perfect_hash_map(std::vector<std::pair<std::string, T>> entries)
+    {
+        std::size_t size = 1;
+        while (size < entries.size()) {
+            size *= 2;
+        }
+        while (!build(entries, size)) {
+            // only names with colliding hashes cannot be placed
+            if (size > kMaxGrowth * std::max<std::size_t>(1, entries.size())) {
+                throw std::runtime_error{"cannot build perfect hash"};
+            }
+            size *= 2;
+        }
+    }
+
+    //! Find a value by name, nullptr if the name is unknown
+    const T* find(std::string_view name) const noexcept
+    {
+        if (slots_.empty()) {
+            return nullptr;
+        }
+        auto hash = hash_name(name);
+        auto seed = seeds_[hash % seeds_.size()];
+        const auto& slot = slots_[mix(hash, seed) & (slots_.size() - 1)];
+        if (!slot || slot->first != name) {
+            return nullptr;
+        }
+        return &slot->second;
+    }
+
+    std::size_t size() const noexcept { return size_; }
+
+private:
+    //! Number of seeds tried for a bucket before growing the table
+    static constexpr std::uint64_t kMaxSeed = 1024;
+    //! Maximum ratio between the number of slots and of names
+    static constexpr std::size_t kMaxGrowth = 64;
+
+    static std::uint64_t hash_name(std::string_view name) noexcept
+    {
+        // FNV-1a
+        std::uint64_t hash = 14695981039346656037ull;
+        for (char c : name) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    static std::uint64_t mix(std::uint64_t hash, std::uint64_t seed) noexcept
+    {
+        // splitmix64 finalizer
+        hash ^= seed * 0x9e3779b97f4a7c15ull;
+        hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+        hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+        return hash ^ (hash >> 31);
+    }
+
+    bool build(std::vector<std::pair<std::string, T>>& entries, std::size_t size)
+    {
+        std::vector<std::uint64_t> hashes;
+        hashes.reserve(entries.size());
+        for (const auto& entry : entries) {
+            hashes.push_back(hash_name(entry.first));
+        }
+
+        std::size_t n_buckets = std::max<std::size_t>(1, entries.size() / 2);
+        std::vector<std::vector<std::size_t>> buckets(n_buckets);
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            buckets[hashes[i] % n_buckets].push_back(i);
+        }
+        std::vector<std::size_t> order(n_buckets);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](auto lhs, auto rhs) {
+            return buckets[lhs].size() > buckets[rhs].size();
+        });
+
+        std::vector<std::uint64_t> seeds(n_buckets, 0);
+        std::vector<std::optional<std::size_t>> placement(size);
+        std::vector<std::size_t> candidate;
+        for (auto bucket_idx : order) {
+            const auto& bucket = buckets[bucket_idx];
+            if (bucket.empty()) {
+                break;
+            }
+
+            bool placed = false;
+            for (std::uint64_t seed = 0; seed < kMaxSeed && !placed; ++seed) {
+                candidate.clear();
+                placed = true;
+                for (auto entry_idx : bucket) {
+                    auto slot = mix(hashes[entry_idx], seed) & (size - 1);
+                    if (placement[slot]
+                        || std::find(candidate.begin(), candidate.end(), slot)
+                               != candidate.end()) {
+                        placed = false;
+                        break;
+                    }
+                    candidate.push_back(slot);
+                }
+                if (placed) {
+                    seeds[bucket_idx] = seed;
+                    for (std::size_t i = 0; i < bucket.size(); ++i) {
+                        placement[candidate[i]] = bucket[i];
+                    }
+                }
+            }
+            if (!placed) {
+                return false;
+            }
+        }
+
+        slots_.clear();
+        slots_.resize(size);
+        for (std::size_t slot = 0; slot < size; ++slot) {
+            if (placement[slot]) {
+                slots_[slot] = std::move(entries[*placement[slot]]);
+            }
+        }
+        seeds_ = std::move(seeds);
+        size_ = entries.size();
+        return true;
+    }
+
+    std::vector<std::uint64_t> seeds_;
+    std::vector<std::optional<std::pair<std::string, T>>> slots_;
+    std::size_t size_{0};
+};
+
+} // internal
+} // packio
+
+#endif // PACKIO_PERFECT_HASH_H
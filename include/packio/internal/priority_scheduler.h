@@ -0,0 +1,132 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_PRIORITY_SCHEDULER_H
+#define PACKIO_PRIORITY_SCHEDULER_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "config.h"
+#include "movable_function.h"
+
+namespace packio {
+namespace internal {
+
+//! Runs the tasks posted to an executor by order of priority
+//!
+//! Each task is queued by executor and priority, then a token is posted
+//! to its executor. Each token runs the most urgent task queued for its
+//! executor when it is executed, not necessarily the task it was posted
+//! with: tasks of higher priority overtake the tasks already waiting in
+//! the executor. Tasks of the same priority run in FIFO order. A task
+//! only runs on the executor it was posted to, executors comparing equal
+//! share their queues.
+class priority_scheduler
+    : public std::enable_shared_from_this<priority_scheduler> {
+public:
+    using task_type = movable_function<void()>;
+
+    //! Create a scheduler
+    //! @param levels The number of priorities, 0 being the most urgent
+    explicit priority_scheduler(std::size_t levels) : levels_(levels)
+    {
+        assert(levels > 0);
+    }
+
+    //! Get the number of priorities
+    std::size_t levels() const noexcept { return levels_; }
+
+    //! Post a task to an executor
+    //! @param executor The executor running the task
+    //! @param priority The priority of the task, 0 being the most urgent
+    //! @param task The task
+    template <typename Executor>
+    void post(const Executor& executor, std::size_t priority, task_type task)
+    {
+        assert(priority < levels_);
+        any_io_executor target{executor};
+        std::shared_ptr<lane> lane_ptr;
+        {
+            std::unique_lock lock{mutex_};
+            auto it = std::find_if(
+                lanes_.begin(), lanes_.end(), [&](const auto& lane) {
+                    return lane->executor == target;
+                });
+            if (it != lanes_.end()) {
+                lane_ptr = *it;
+            }
+            else {
+                lane_ptr = std::make_shared<lane>(std::move(target), levels_);
+                lanes_.push_back(lane_ptr);
+            }
+            lane_ptr->queues[priority].push_back(std::move(task));
+            ++lane_ptr->size;
+        }
+        net::post(
+            executor, [self = shared_from_this(), lane_ptr = std::move(lane_ptr)] {
+                self->run_one(lane_ptr);
+            });
+    }
+
+    //! Get the number of tasks waiting
+    std::size_t size() const
+    {
+        std::unique_lock lock{mutex_};
+        std::size_t size = 0;
+        for (const auto& lane : lanes_) {
+            size += lane->size;
+        }
+        return size;
+    }
+
+private:
+    //! The queues of the tasks posted to an executor
+    struct lane {
+        lane(any_io_executor executor, std::size_t levels)
+            : executor{std::move(executor)}, queues(levels)
+        {
+        }
+
+        any_io_executor executor;
+        std::vector<std::deque<task_type>> queues;
+        std::size_t size{0};
+    };
+
+    void run_one(const std::shared_ptr<lane>& lane_ptr)
+    {
+        task_type task;
+        {
+            std::unique_lock lock{mutex_};
+            for (auto& queue : lane_ptr->queues) {
+                if (!queue.empty()) {
+                    task = std::move(queue.front());
+                    queue.pop_front();
+                    break;
+                }
+            }
+            // each token is posted with its task, the last token of
+            // the lane removes it
+            if (--lane_ptr->size == 0) {
+                lanes_.erase(std::find(lanes_.begin(), lanes_.end(), lane_ptr));
+            }
+        }
+        assert(task);
+        task();
+    }
+
+    const std::size_t levels_;
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<lane>> lanes_;
+};
+
+} // internal
+} // packio
+
+#endif // PACKIO_PRIORITY_SCHEDULER_H
@@ -0,0 +1,188 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_RCU_H
+#define PACKIO_RCU_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace packio {
+namespace internal {
+
+//! Immutable value published with read-copy-update
+//!
+//! Readers get the current value without locking, and keep it alive
+//! with a reader guard. Writers publish a new value, the previous one
+//! is retired and deleted when all the readers that could see it have
+//! released their guard. Readers register in per-thread counters
+//! tagged with the parity of an epoch: the epoch advances once the
+//! readers of the previous epoch are gone, and a value retired at epoch
+//! e is deleted at epoch e + 2. Writers never wait for readers.
+//! Writers must be serialized by the caller.
+template <typename T>
+class rcu {
+public:
+    //! Number of reader counters, threads are spread over them
+    static constexpr std::size_t kReaderSlots = 64;
+
+    //! Keeps the values visible to a reader alive
+    class reader_guard {
+    public:
+        reader_guard() noexcept = default;
+        reader_guard(const rcu* domain, std::atomic<std::size_t>* counter) noexcept
+            : domain_{domain}, counter_{counter}
+        {
+        }
+
+        reader_guard(const reader_guard&) = delete;
+        reader_guard& operator=(const reader_guard&) = delete;
+
+        reader_guard(reader_guard&& other) noexcept
+            : domain_{std::exchange(other.domain_, nullptr)},
+              counter_{std::exchange(other.counter_, nullptr)}
+        {
+        }
+
+        reader_guard& operator=(reader_guard&& other) noexcept
+        {
+            if (this != &other) {
+                release();
+                domain_ = std::exchange(other.domain_, nullptr);
+                counter_ = std::exchange(other.counter_, nullptr);
+            }
+            return *this;
+        }
+
+        ~reader_guard() { release(); }
+
+        void release() noexcept
+        {
+            if (!counter_) {
+                return;
+            }
+            counter_->fetch_sub(1, std::memory_order_seq_cst);
+            counter_ = nullptr;
+            if (domain_->has_retired_.load(std::memory_order_relaxed)) {
+                domain_->try_reclaim();
+            }
+            domain_ = nullptr;
+        }
+
+    private:
+        const rcu* domain_{nullptr};
+        std::atomic<std::size_t>* counter_{nullptr};
+    };
+
+    rcu() = default;
+    rcu(const rcu&) = delete;
+    rcu& operator=(const rcu&) = delete;
+
+    //! Get the current value, or nullptr, and the guard keeping it alive
+    std::pair<const T*, reader_guard> read() const noexcept
+    {
+        auto epoch = epoch_.load(std::memory_order_seq_cst);
+        auto& counter = slots_[reader_slot()].counters[epoch & 1];
+        counter.fetch_add(1, std::memory_order_seq_cst);
+        return {
+            current_.load(std::memory_order_seq_cst),
+            reader_guard{this, &counter}};
+    }
+
+    //! Replace the current value, must not be called concurrently
+    void publish(std::unique_ptr<const T> value)
+    {
+        std::unique_lock lock{reclaim_mutex_};
+        current_.store(value.get(), std::memory_order_seq_cst);
+        auto previous = std::exchange(owned_, std::move(value));
+        if (previous) {
+            retired_.push_back(
+                {std::move(previous), epoch_.load(std::memory_order_seq_cst)});
+            has_retired_.store(true, std::memory_order_relaxed);
+        }
+        reclaim();
+    }
+
+    //! Number of retired values not deleted yet
+    std::size_t retired() const
+    {
+        std::unique_lock lock{reclaim_mutex_};
+        return retired_.size();
+    }
+
+private:
+    struct alignas(64) reader_slot_type {
+        std::array<std::atomic<std::size_t>, 2> counters{};
+    };
+
+    struct retired_value {
+        std::unique_ptr<const T> value;
+        std::uint64_t epoch;
+    };
+
+    static std::size_t reader_slot() noexcept
+    {
+        static std::atomic<std::size_t> next_slot{0};
+        thread_local const std::size_t slot =
+            next_slot.fetch_add(1, std::memory_order_relaxed) % kReaderSlots;
+        return slot;
+    }
+
+    void try_reclaim() const
+    {
+        std::unique_lock lock{reclaim_mutex_, std::try_to_lock};
+        if (lock) {
+            reclaim();
+        }
+    }
+
+    bool try_advance() const
+    {
+        // the readers of the previous epoch share the parity of the next one
+        auto epoch = epoch_.load(std::memory_order_seq_cst);
+        auto parity = (epoch + 1) & 1;
+        for (const auto& slot : slots_) {
+            if (slot.counters[parity].load(std::memory_order_seq_cst) != 0) {
+                return false;
+            }
+        }
+        epoch_.store(epoch + 1, std::memory_order_seq_cst);
+        return true;
+    }
+
+    void reclaim() const
+    {
+        if (try_advance()) {
+            try_advance();
+        }
+
+        auto epoch = epoch_.load(std::memory_order_seq_cst);
+        auto it = retired_.begin();
+        while (it != retired_.end() && it->epoch + 2 <= epoch) {
+            ++it;
+        }
+        retired_.erase(retired_.begin(), it);
+        has_retired_.store(!retired_.empty(), std::memory_order_relaxed);
+    }
+
+    std::atomic<const T*> current_{nullptr};
+    std::unique_ptr<const T> owned_;
+
+    mutable std::mutex reclaim_mutex_;
+    mutable std::atomic<std::uint64_t> epoch_{0};
+    mutable std::vector<retired_value> retired_;
+    mutable std::atomic<bool> has_retired_{false};
+    mutable std::array<reader_slot_type, kReaderSlots> slots_{};
+};
+
+} // internal
+} // packio
+
+#endif // PACKIO_RCU_H
@@ -7,11 +7,25 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 
 namespace packio {
 
 enum class call_type { request = 0, notification = 1 };
 
+//! Error of a call, as returned by the remote procedure
+struct call_error {
+    //! The error message
+    std::string message;
+};
+
+namespace internal {
+
+//! Name of the procedure listing the numeric method IDs of a frozen dispatcher
+constexpr std::string_view kMethodIdsProcedure = "packio.method_ids";
+
+} // internal
+
 } // packio
 
 #endif // PACKIO_RPC_H
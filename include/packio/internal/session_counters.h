@@ -0,0 +1,41 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_SESSION_COUNTERS_H
+#define PACKIO_SESSION_COUNTERS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "config.h"
+#include "metrics.h"
+
+namespace packio {
+namespace internal {
+
+//! Counters of the sessions of a server, shared with its sessions
+struct session_counters {
+    //! Sessions currently alive
+    std::atomic<std::size_t> active{0};
+    //! Connections accepted since the server creation
+    std::atomic<std::uint64_t> accepted{0};
+    //! Connections closed because of the session limit
+    std::atomic<std::uint64_t> rejected{0};
+    //! Sessions closed because of a timeout
+    std::atomic<std::uint64_t> timed_out{0};
+    //! Requests shed by the load shedding
+    std::atomic<std::uint64_t> shed{0};
+    //! Requests rejected by a rate limit
+    std::atomic<std::uint64_t> rate_limited{0};
+#if PACKIO_HAS_METRICS
+    //! Traffic of the sessions
+    sharded_session_metrics metrics;
+#endif // PACKIO_HAS_METRICS
+};
+
+} // internal
+} // packio
+
+#endif // PACKIO_SESSION_COUNTERS_H
@@ -0,0 +1,130 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_TIMER_WHEEL_H
+#define PACKIO_TIMER_WHEEL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace packio {
+namespace internal {
+
+//! Hashed timer wheel
+//!
+//! Deadlines are hashed into buckets by tick, so scheduling is O(1)
+//! and a single timer can serve any number of deadlines. Entries are
+//! not removed when the associated operation completes: the caller
+//! must ignore the expiration of IDs that are not pending anymore.
+class timer_wheel {
+public:
+    using clock_type = std::chrono::steady_clock;
+    using id_type = std::uint64_t;
+
+    //! The default duration of a tick
+    static constexpr clock_type::duration kDefaultResolution =
+        std::chrono::milliseconds{10};
+    //! The default number of buckets
+    static constexpr std::size_t kDefaultSize = 512;
+
+    explicit timer_wheel(
+        clock_type::duration resolution = kDefaultResolution,
+        std::size_t size = kDefaultSize)
+        : resolution_{resolution}, buckets_(size)
+    {
+    }
+
+    bool empty() const noexcept { return size_ == 0; }
+
+    void insert(id_type id, clock_type::time_point deadline)
+    {
+        // a deadline in the past expires on the next tick
+        auto tick = std::max(to_tick(deadline), current_tick_);
+        next_tick_ = empty() ? tick : std::min(next_tick_, tick);
+        buckets_[tick % buckets_.size()].push_back({id, tick});
+        ++size_;
+    }
+
+    //! Time point at which the next expiration must be processed
+    clock_type::time_point next_expiry() const
+    {
+        return clock_type::time_point{next_tick_ * resolution_};
+    }
+
+    //! Expire all entries with a deadline before now
+    //! @param now The current time
+    //! @param fct Function called with the ID of each expired entry
+    template <typename F>
+    void expire(clock_type::time_point now, F&& fct)
+    {
+        auto now_tick = static_cast<id_type>(now.time_since_epoch() / resolution_);
+        if (now_tick < current_tick_) {
+            return;
+        }
+
+        // visit each bucket at most once
+        auto last_tick = std::min(
+            now_tick, current_tick_ + static_cast<id_type>(buckets_.size()) - 1);
+        for (auto tick = current_tick_; tick <= last_tick; ++tick) {
+            auto& bucket = buckets_[tick % buckets_.size()];
+            for (std::size_t i = 0; i < bucket.size();) {
+                if (bucket[i].tick <= now_tick) {
+                    auto id = bucket[i].id;
+                    bucket[i] = bucket.back();
+                    bucket.pop_back();
+                    --size_;
+                    fct(id);
+                }
+                else {
+                    ++i;
+                }
+            }
+        }
+        current_tick_ = now_tick + 1;
+
+        // the first non-empty bucket holds the earliest deadline,
+        // or a deadline of a later round in which case we wake up early
+        next_tick_ = current_tick_;
+        if (!empty()) {
+            while (buckets_[next_tick_ % buckets_.size()].empty()) {
+                ++next_tick_;
+            }
+        }
+    }
+
+    void clear()
+    {
+        for (auto& bucket : buckets_) {
+            bucket.clear();
+        }
+        size_ = 0;
+    }
+
+private:
+    struct entry {
+        id_type id;
+        id_type tick;
+    };
+
+    id_type to_tick(clock_type::time_point tp) const
+    {
+        // round up, deadlines never expire early
+        auto ticks = (tp.time_since_epoch() + resolution_ - clock_type::duration{1})
+                     / resolution_;
+        return static_cast<id_type>(ticks);
+    }
+
+    clock_type::duration resolution_;
+    std::vector<std::vector<entry>> buckets_;
+    std::size_t size_{0};
+    id_type current_tick_{0};
+    id_type next_tick_{0};
+};
+
+} // internal
+} // packio
+
+#endif // PACKIO_TIMER_WHEEL_H
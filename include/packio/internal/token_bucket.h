@@ -0,0 +1,122 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_TOKEN_BUCKET_H
+#define PACKIO_TOKEN_BUCKET_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+
+namespace packio {
+namespace internal {
+
+//! Token bucket rate limiter
+//!
+//! The bucket holds up to burst tokens and is refilled at rate tokens
+//! per second, each request takes a token. It is implemented as a
+//! generic cell rate algorithm: a single timestamp, the theoretical
+//! arrival time of the next request, is advanced by 1 / rate for each
+//! request accepted, and a request is rejected when this time is more
+//! than (burst - 1) / rate in the future. Lock-free and thread-safe,
+//! the rate can be changed at any time.
+class token_bucket {
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    token_bucket() = default;
+    token_bucket(double rate, std::size_t burst) { set_rate(rate, burst); }
+
+    token_bucket(const token_bucket&) = delete;
+    token_bucket& operator=(const token_bucket&) = delete;
+
+    //! Set the rate, zero disables the limit
+    //! @param rate Tokens added per second
+    //! @param burst Maximum number of tokens, at least one
+    void set_rate(double rate, std::size_t burst) noexcept
+    {
+        burst = std::max<std::size_t>(burst, 1);
+        rate_.store(std::max(rate, 0.), std::memory_order_relaxed);
+        burst_.store(burst, std::memory_order_relaxed);
+        if (rate <= 0) {
+            interval_.store(0, std::memory_order_relaxed);
+            return;
+        }
+        auto interval = std::max<clock_type::rep>(
+            1,
+            std::chrono::duration_cast<clock_type::duration>(
+                std::chrono::duration<double>{1. / rate})
+                .count());
+        tolerance_.store(
+            interval * static_cast<clock_type::rep>(burst - 1),
+            std::memory_order_relaxed);
+        interval_.store(interval, std::memory_order_relaxed);
+    }
+
+    //! Get the rate, zero if the limit is disabled
+    double rate() const noexcept
+    {
+        return enabled() ? rate_.load(std::memory_order_relaxed) : 0.;
+    }
+    //! Get the maximum number of tokens
+    std::size_t burst() const noexcept
+    {
+        return burst_.load(std::memory_order_relaxed);
+    }
+    //! Check if the limit is enabled
+    bool enabled() const noexcept
+    {
+        return interval_.load(std::memory_order_relaxed) != 0;
+    }
+
+    //! Take a token
+    //! @param now The current time
+    //! @return True if a token was available, always true if the limit
+    //! is disabled
+    bool try_acquire(clock_type::time_point now = clock_type::now()) noexcept
+    {
+        auto interval = interval_.load(std::memory_order_relaxed);
+        if (interval == 0) {
+            return true;
+        }
+        auto tolerance = tolerance_.load(std::memory_order_relaxed);
+        auto time = now.time_since_epoch().count();
+        auto arrival = next_arrival_.load(std::memory_order_relaxed);
+        while (true) {
+            auto start = std::max(arrival, time);
+            if (start - time > tolerance) {
+                return false;
+            }
+            if (next_arrival_.compare_exchange_weak(
+                    arrival, start + interval, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+    //! Give back a token taken by try_acquire, for a request that was
+    //! rejected for another reason
+    void release() noexcept
+    {
+        auto interval = interval_.load(std::memory_order_relaxed);
+        if (interval != 0) {
+            next_arrival_.fetch_sub(interval, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::atomic<double> rate_{0.};
+    std::atomic<std::size_t> burst_{1};
+    std::atomic<clock_type::rep> interval_{0};
+    std::atomic<clock_type::rep> tolerance_{0};
+    std::atomic<clock_type::rep> next_arrival_{
+        std::numeric_limits<clock_type::rep>::min()};
+};
+
+} // internal
+} // packio
+
+#endif // PACKIO_TOKEN_BUCKET_H
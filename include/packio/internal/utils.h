@@ -77,6 +77,24 @@ struct is_tuple<T, std::void_t<decltype(std::tuple_size<std::decay_t<T>>::value)
 template <typename T>
 constexpr auto is_tuple_v = is_tuple<T>::value;
 
+template <typename T>
+struct is_executor
+    : std::bool_constant<
+          net::is_executor<T>::value
+#if (PACKIO_STANDALONE_ASIO && ASIO_VERSION >= 101700) \
+    || (!PACKIO_STANDALONE_ASIO && BOOST_VERSION >= 107400)
+          || net::execution::is_executor<T>::value
+#endif
+          > {
+};
+
+template <typename T>
+constexpr auto is_executor_v = is_executor<T>::value;
+
+template <typename T>
+constexpr auto is_execution_context_v =
+    std::is_convertible_v<T&, net::execution_context&>;
+
 template <typename T>
 struct left_shift_tuple;
 
@@ -109,6 +127,19 @@ struct always_false : std::false_type {
 template <typename... Args>
 constexpr auto always_false_v = always_false<Args...>::value;
 
+//! Sockets whose adapter sets kCancellable to false cannot interrupt reads
+template <typename T, typename = void>
+struct is_cancellable : std::true_type {
+};
+
+template <typename T>
+struct is_cancellable<T, std::void_t<decltype(T::kCancellable)>>
+    : std::bool_constant<T::kCancellable> {
+};
+
+template <typename T>
+constexpr bool is_cancellable_v = is_cancellable<T>::value;
+
 template <typename T>
 void set_no_delay(T&)
 {
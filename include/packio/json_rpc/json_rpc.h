@@ -10,7 +10,9 @@
 //! based on the boost::json library
 
 #include "../client.h"
+#include "../client_pool.h"
 #include "../server.h"
+#include "../server_pool.h"
 #include "rpc.h"
 
 //! @namespace packio::json_rpc
@@ -37,6 +39,21 @@ auto make_client(Socket&& socket)
     return std::make_shared<client<Socket, Map>>(std::forward<Socket>(socket));
 }
 
+//! The @ref packio::client_pool "client_pool" for JSON-RPC
+template <typename Socket, template <class...> class Map = default_map>
+using client_pool = ::packio::client_pool<rpc, Socket, Map>;
+
+//! The @ref packio::make_client_pool "make_client_pool" function for JSON-RPC
+template <
+    typename Socket,
+    template <class...> class Map = default_map,
+    typename ExecutorOrContext>
+auto make_client_pool(ExecutorOrContext&& context, std::size_t size)
+{
+    return ::packio::make_client_pool<rpc, Socket, Map>(
+        std::forward<ExecutorOrContext>(context), size);
+}
+
 //! The @ref packio::server "server" for JSON-RPC
 template <typename Acceptor, typename Dispatcher = dispatcher<>>
 using server = ::packio::server<rpc, Acceptor, Dispatcher>;
@@ -49,6 +66,10 @@ auto make_server(Acceptor&& acceptor)
         std::forward<Acceptor>(acceptor));
 }
 
+//! The @ref packio::server_pool "server_pool" for JSON-RPC
+template <typename Acceptor, typename Dispatcher = dispatcher<>>
+using server_pool = ::packio::server_pool<rpc, Acceptor, Dispatcher>;
+
 } // json_rpc
 } // packio
 
@@ -6,7 +6,11 @@
 #define PACKIO_JSON_RPC_RPC_H
 
 #include <array>
+#include <cstdint>
+#include <deque>
+#include <optional>
 #include <queue>
+#include <string_view>
 
 #include <boost/json.hpp>
 
@@ -39,8 +43,17 @@ using packio::internal::unexpected;
 struct request {
     call_type type;
     internal::id_type id;
-    std::string method;
+    std::string_view method; //!< Procedure name, stored in the request object
+    //! Numeric ID sent instead of the method name, see dispatcher::freeze
+    std::optional<std::uint64_t> method_id;
     native_type args;
+    //! Number of requests of the batch starting with this request, 0 otherwise
+    std::size_t batch_size{0};
+    //! Why the request is invalid, empty if it is valid. Invalid requests
+    //! are answered with an Invalid Request error
+    std::string invalid;
+
+    boost::json::object object; //!< The request object storing the method
 };
 
 //! The object representing the response to a call
@@ -50,6 +63,12 @@ struct response {
     native_type error;
 };
 
+//! The pre-encoded part of the requests to a procedure
+struct prepared_request {
+    std::string method; //!< The procedure name
+    std::string header; //!< Encoded request, up to the params value
+};
+
 //! The incremental parser for JSON-RPC objects
 class incremental_parser {
 public:
@@ -61,22 +80,40 @@ public:
 
     expected<request, std::string> get_request()
     {
-        if (parsed_.empty()) {
-            return unexpected{"no request parsed"};
+        if (requests_.empty()) {
+            if (parsed_.empty()) {
+                return unexpected{"no request parsed"};
+            }
+            auto value = std::move(parsed_.front());
+            parsed_.pop();
+            if (!value.is_array()) {
+                return parse_request(std::move(value.as_object()));
+            }
+            parse_request_batch(std::move(value.get_array()));
         }
-        auto object = std::move(parsed_.front());
-        parsed_.pop();
-        return parse_request(std::move(object.as_object()));
+        auto request = std::move(requests_.front());
+        requests_.pop_front();
+        return {std::move(request)};
     }
 
     expected<response, std::string> get_response()
     {
-        if (parsed_.empty()) {
-            return unexpected{"no response parsed"};
+        if (responses_.empty()) {
+            if (parsed_.empty()) {
+                return unexpected{"no response parsed"};
+            }
+            auto value = std::move(parsed_.front());
+            parsed_.pop();
+            if (!value.is_array()) {
+                return parse_response(std::move(value.as_object()));
+            }
+            if (!parse_response_batch(std::move(value.get_array()))) {
+                return unexpected{"empty batch"};
+            }
         }
-        auto object = std::move(parsed_.front());
-        parsed_.pop();
-        return parse_response(std::move(object.as_object()));
+        auto response = std::move(responses_.front());
+        responses_.pop_front();
+        return {std::move(response)};
     }
 
     char* buffer()
@@ -93,11 +130,23 @@ public:
     { //
         std::size_t parsed = 0;
         while (parsed < bytes) {
-            parsed += parser_->write_some(
+            if (unparsed_ == 0) {
+                // whitespace between values does not start a message
+                const char* data = buffer_.data() + parsed;
+                if (*data == ' ' || *data == '\n' || *data == '\r'
+                    || *data == '\t') {
+                    ++parsed;
+                    continue;
+                }
+            }
+            auto written = parser_->write_some(
                 buffer_.data() + parsed, bytes - parsed);
+            parsed += written;
+            unparsed_ += written;
             if (parser_->done()) {
                 parsed_.push(parser_->release());
                 parser_->reset();
+                unparsed_ = 0;
             }
         }
     }
@@ -107,7 +156,84 @@ public:
         buffer_.resize(bytes);
     }
 
+    //! Size of the received data not forming a complete message yet
+    std::size_t unparsed_size() const
+    { //
+        return unparsed_;
+    }
+
+    //! Release the buffer capacity, partial messages are held by the parser
+    void shrink_buffer()
+    {
+        buffer_.clear();
+        buffer_.shrink_to_fit();
+    }
+
 private:
+    void parse_request_batch(boost::json::array&& batch)
+    {
+        // an empty batch is answered with a single error, not a batch
+        if (batch.empty()) {
+            requests_.push_back(invalid_request("empty batch"));
+            return;
+        }
+        auto first = requests_.size();
+        for (auto& item : batch) {
+            if (!item.is_object()) {
+                PACKIO_INFO("invalid request in batch: not an object");
+                requests_.push_back(invalid_request("request is not an object"));
+                continue;
+            }
+            auto request = parse_request(std::move(item.get_object()));
+            if (!request) {
+                PACKIO_INFO("invalid request in batch: {}", request.error());
+                requests_.push_back(invalid_request(
+                    std::move(request.error()),
+                    invalid_request_id(item.get_object())));
+                continue;
+            }
+            requests_.push_back(std::move(*request));
+        }
+        requests_[first].batch_size = requests_.size() - first;
+    }
+
+    static request invalid_request(std::string reason, id_type id = nullptr)
+    {
+        request invalid;
+        invalid.type = call_type::request;
+        invalid.id = std::move(id);
+        invalid.invalid = std::move(reason);
+        return invalid;
+    }
+
+    //! The id of an invalid request if it is a string or a number, null otherwise
+    static id_type invalid_request_id(const boost::json::object& req)
+    {
+        auto id_it = req.find("id");
+        if (id_it == req.end()
+            || !(id_it->value().is_string() || id_it->value().is_number())) {
+            return nullptr;
+        }
+        return id_it->value();
+    }
+
+    bool parse_response_batch(boost::json::array&& batch)
+    {
+        for (auto& item : batch) {
+            if (!item.is_object()) {
+                PACKIO_INFO("invalid response in batch: not an object");
+                continue;
+            }
+            auto response = parse_response(std::move(item.get_object()));
+            if (!response) {
+                PACKIO_INFO("invalid response in batch: {}", response.error());
+                continue;
+            }
+            responses_.push_back(std::move(*response));
+        }
+        return !responses_.empty();
+    }
+
     static expected<response, std::string> parse_response(boost::json::object&& res)
     {
         auto id_it = res.find("id");
@@ -141,15 +267,22 @@ private:
         if (method_it == req.end()) {
             return unexpected{"missing method field"};
         }
-        if (!method_it->value().is_string()) {
+        // unsigned integer methods are numeric method IDs, an extension
+        // to JSON-RPC only used by clients that negotiated them
+        const auto& method = method_it->value();
+        bool numeric = method.is_uint64()
+                       || (method.is_int64() && method.get_int64() >= 0);
+        if (!method.is_string() && !numeric) {
             return unexpected{"method field is not a string"};
         }
 
         request parsed;
-        parsed.method = std::string{
-            method_it->value().get_string().data(),
-            method_it->value().get_string().size(),
-        };
+        if (method.is_uint64()) {
+            parsed.method_id = method.get_uint64();
+        }
+        else if (numeric) {
+            parsed.method_id = static_cast<std::uint64_t>(method.get_int64());
+        }
         if (params_it == req.end() || params_it->value().is_null()) {
             parsed.args = boost::json::array{};
         }
@@ -167,12 +300,24 @@ private:
             parsed.type = call_type::request;
             parsed.id = std::move(id_it->value());
         }
+
+        // the method name is a view on the request object,
+        // which is kept alive with the request
+        parsed.object = std::move(req);
+        if (!parsed.method_id) {
+            const auto& name = parsed.object.at("method").get_string();
+            parsed.method = std::string_view{name.data(), name.size()};
+        }
         return {std::move(parsed)};
     }
 
     std::vector<char> buffer_;
     std::queue<boost::json::value> parsed_;
+    std::deque<request> requests_;
+    std::deque<response> responses_;
     std::unique_ptr<boost::json::stream_parser> parser_;
+    //! Bytes written to the parser since the last complete value
+    std::size_t unparsed_{0};
 };
 
 } // internal
@@ -195,11 +340,25 @@ public:
     //! The incremental parser type
     using incremental_parser_type = internal::incremental_parser;
 
+    //! The type of the pre-encoded part of a request
+    using prepared_request_type = internal::prepared_request;
+
     static std::string format_id(const id_type& id)
     { //
         return boost::json::serialize(id);
     }
 
+    static std::optional<std::uint64_t> integer_id(const id_type& id)
+    {
+        if (id.is_uint64()) {
+            return id.get_uint64();
+        }
+        if (id.is_int64() && id.get_int64() >= 0) {
+            return static_cast<std::uint64_t>(id.get_int64());
+        }
+        return std::nullopt;
+    }
+
     template <typename... Args>
     static auto serialize_notification(std::string_view method, Args&&... args)
         -> std::enable_if_t<internal::positional_args_v<Args...>, std::string>
@@ -281,6 +440,47 @@ public:
             "JSON-RPC does not support mixed named and unnamed arguments");
     }
 
+    static prepared_request_type prepare_request(std::string_view method)
+    {
+        return {
+            std::string{method},
+            "{\"jsonrpc\":\"2.0\",\"method\":"
+                + boost::json::serialize(boost::json::value_from(method))
+                + ",\"params\":",
+        };
+    }
+
+    static prepared_request_type prepare_request(
+        std::string_view method,
+        std::uint64_t method_id)
+    {
+        return {
+            std::string{method},
+            "{\"jsonrpc\":\"2.0\",\"method\":" + std::to_string(method_id)
+                + ",\"params\":",
+        };
+    }
+
+    template <typename... Args>
+    static std::string serialize_request(
+        const id_type& id,
+        const prepared_request_type& request,
+        Args&&... args)
+    {
+        auto params = serialize_params(std::forward<Args>(args)...);
+        auto id_str = boost::json::serialize(id);
+
+        std::string res;
+        res.reserve(request.header.size() + params.size() + id_str.size() + 7);
+        res += request.header;
+        res += params;
+        res += ",\"id\":";
+        res += id_str;
+        res += '}';
+        PACKIO_TRACE("request: " + res);
+        return res;
+    }
+
     static std::string serialize_response(const id_type& id)
     {
         return serialize_response(id, boost::json::value{});
@@ -298,31 +498,123 @@ public:
         return res;
     }
 
+    //! Serialize the arguments of a request, two requests with the same
+    //! arguments have the same serialized arguments
+    static std::string serialize_args(const native_type& args)
+    {
+        return boost::json::serialize(args);
+    }
+
+    //! Serialize a result independently of the request it answers, see
+    //! @ref serialize_serialized_response
     template <typename T>
-    static std::string serialize_error_response(const id_type& id, T&& value)
+    static std::string serialize_result(T&& value)
+    {
+        return boost::json::serialize(
+            boost::json::value_from(std::forward<T>(value)));
+    }
+
+    //! Serialize an error independently of the request it answers, see
+    //! @ref serialize_serialized_response
+    template <typename T>
+    static std::string serialize_error(T&& value)
+    {
+        return boost::json::serialize(make_error(std::forward<T>(value)));
+    }
+
+    //! Serialize a response from a result serialized with @ref serialize_result,
+    //! or from an error serialized with @ref serialize_error
+    static std::string serialize_serialized_response(
+        const id_type& id,
+        std::string_view result,
+        bool error = false)
+    {
+        auto id_str = boost::json::serialize(id);
+
+        std::string res;
+        res.reserve(result.size() + id_str.size() + 32);
+        res += "{\"jsonrpc\":\"2.0\",\"id\":";
+        res += id_str;
+        res += error ? ",\"error\":" : ",\"result\":";
+        res += result;
+        res += '}';
+        PACKIO_TRACE("response: " + res);
+        return res;
+    }
+
+    //! Serialize the Invalid Request error answering an invalid request
+    static std::string serialize_invalid_request_response(const id_type& id)
     {
         auto res = boost::json::serialize(boost::json::object({
             {"jsonrpc", "2.0"},
             {"id", id},
             {"error",
-             [&]() {
-                 boost::json::object error = {
-                     {"code", -32000}, // -32000 is an implementation-defined error
-                     {"data", std::forward<T>(value)},
-                 };
-                 if (error["data"].is_string()) {
-                     error["message"] = error["data"];
-                 }
-                 else {
-                     error["message"] = "unknown error";
-                 }
-                 return error;
-             }()},
+             boost::json::object({
+                 {"code", -32600},
+                 {"message", "Invalid Request"},
+             })},
         }));
         PACKIO_TRACE("response: " + res);
         return res;
     }
 
+    template <typename T>
+    static std::string serialize_error_response(const id_type& id, T&& value)
+    {
+        auto res = boost::json::serialize(boost::json::object({
+            {"jsonrpc", "2.0"},
+            {"id", id},
+            {"error", make_error(std::forward<T>(value))},
+        }));
+        PACKIO_TRACE("response: " + res);
+        return res;
+    }
+
+    //! Convert the result of a call
+    //! @return The converted result, or the error returned by the procedure
+    template <typename T>
+    static internal::expected<T, call_error> extract_result(
+        const response_type& response)
+    {
+        if (!response.error.is_null()) {
+            const auto* error = response.error.if_object();
+            const auto* message = error ? error->if_contains("message") : nullptr;
+            if (message && message->is_string()) {
+                return internal::unexpected{call_error{std::string{
+                    message->get_string().data(), message->get_string().size()}}};
+            }
+            return internal::unexpected{call_error{"unknown error"}};
+        }
+        try {
+            return boost::json::value_to<T>(response.result);
+        }
+        catch (const std::exception& exc) {
+            return internal::unexpected{
+                call_error{std::string{"cannot convert result: "} + exc.what()}};
+        }
+    }
+
+    //! Serialize several messages as a JSON-RPC batch
+    static std::string serialize_batch(std::vector<std::string>&& messages)
+    {
+        std::size_t size = messages.size() + 1;
+        for (const auto& message : messages) {
+            size += message.size();
+        }
+
+        std::string batch;
+        batch.reserve(size);
+        batch.push_back('[');
+        for (const auto& message : messages) {
+            if (batch.size() > 1) {
+                batch.push_back(',');
+            }
+            batch += message;
+        }
+        batch.push_back(']');
+        return batch;
+    }
+
     static net::const_buffer buffer(const std::string& buf)
     {
         return net::const_buffer(buf.data(), buf.size());
@@ -351,6 +643,48 @@ public:
     }
 
 private:
+    template <typename T>
+    static boost::json::object make_error(T&& value)
+    {
+        boost::json::object error = {
+            {"code", -32000}, // -32000 is an implementation-defined error
+            {"data", std::forward<T>(value)},
+        };
+        if (error["data"].is_string()) {
+            error["message"] = error["data"];
+        }
+        else {
+            error["message"] = "unknown error";
+        }
+        return error;
+    }
+
+    template <typename... Args>
+    static auto serialize_params(Args&&... args)
+        -> std::enable_if_t<internal::positional_args_v<Args...>, std::string>
+    {
+        return boost::json::serialize(boost::json::array{
+            boost::json::value_from(std::forward<Args>(args))...});
+    }
+
+    template <typename... Args>
+    static auto serialize_params(Args&&... args)
+        -> std::enable_if_t<internal::named_args_v<Args...>, std::string>
+    {
+        return boost::json::serialize(boost::json::object{
+            {args.name, boost::json::value_from(args.value)}...});
+    }
+
+    template <typename... Args>
+    static auto serialize_params(Args&&...) -> std::enable_if_t<
+        !internal::positional_args_v<Args...> && !internal::named_args_v<Args...>,
+        std::string>
+    {
+        static_assert(
+            internal::positional_args_v<Args...> || internal::named_args_v<Args...>,
+            "JSON-RPC does not support mixed named and unnamed arguments");
+    }
+
     template <typename T, typename F>
     static constexpr T convert_positional_args(
         const boost::json::array& array,
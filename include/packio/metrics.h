@@ -0,0 +1,343 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_METRICS_H
+#define PACKIO_METRICS_H
+
+//! @file
+//! Metrics snapshots and their Prometheus export
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "internal/histogram.h"
+
+namespace packio {
+
+//! Snapshot of a latency histogram, values are in nanoseconds
+//!
+//! Each power of two is divided in 8 buckets of equal width, so the
+//! relative error of a value read from the histogram is at most 12.5%.
+struct histogram_snapshot {
+    std::vector<std::uint64_t> buckets; //!< Count of values per bucket
+    std::uint64_t count{0}; //!< Number of values recorded
+    std::uint64_t sum{0}; //!< Sum of the values recorded
+
+    //! Get the mean of the values, zero if empty
+    double mean() const noexcept
+    {
+        return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.;
+    }
+
+    //! Get an upper bound of the value at a quantile, zero if empty
+    //! @param quantile The quantile, between 0 and 1
+    std::uint64_t value_at_quantile(double quantile) const noexcept
+    {
+        if (count == 0) {
+            return 0;
+        }
+        auto rank = static_cast<std::uint64_t>(quantile * static_cast<double>(count));
+        rank = std::max<std::uint64_t>(1, std::min(rank, count));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < buckets.size(); ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return internal::histogram_layout::upper_bound(i);
+            }
+        }
+        return internal::histogram_layout::upper_bound(buckets.size() - 1);
+    }
+
+    //! Get the number of values strictly lower than a power of two
+    std::uint64_t count_below_power_of_two(unsigned exponent) const noexcept
+    {
+        std::uint64_t below = 0;
+        auto limit = std::uint64_t{1} << exponent;
+        for (std::size_t i = 0; i < buckets.size(); ++i) {
+            if (internal::histogram_layout::upper_bound(i) >= limit) {
+                break;
+            }
+            below += buckets[i];
+        }
+        return below;
+    }
+};
+
+//! Snapshot of the metrics of a procedure
+struct procedure_metrics_snapshot {
+    std::string name; //!< The name of the procedure
+    std::uint64_t calls{0}; //!< Number of completed calls
+    std::uint64_t errors{0}; //!< Number of calls completed with an error
+    //! Time from the reception of the request to the start of the procedure
+    histogram_snapshot queue_time;
+    //! Time from the start of the procedure to its completion
+    histogram_snapshot execution_time;
+    //! Time from the completion of the procedure to the end of the write
+    //! of the response, or of the whole batch for batched calls
+    histogram_snapshot write_time;
+};
+
+//! Snapshot of the traffic of one or several sessions
+struct session_metrics_snapshot {
+    std::uint64_t bytes_in{0}; //!< Bytes read
+    std::uint64_t bytes_out{0}; //!< Bytes written
+    std::uint64_t messages_in{0}; //!< Requests and notifications read
+    std::uint64_t messages_out{0}; //!< Responses written, a batch counts as one
+};
+
+namespace internal {
+
+inline void append_prometheus_label(std::string& out, std::string_view value)
+{
+    for (char c : value) {
+        switch (c) {
+        case '\\':
+            out += "\\\\";
+            break;
+        case '"':
+            out += "\\\"";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        default:
+            out += c;
+        }
+    }
+}
+
+inline void append_prometheus_number(std::string& out, std::uint64_t value)
+{
+    char buffer[32];
+    auto size = std::snprintf(
+        buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value));
+    out.append(buffer, static_cast<std::size_t>(size));
+}
+
+inline void append_prometheus_number(std::string& out, double value)
+{
+    // 15 digits when they read back exactly, 17 always do
+    char buffer[32];
+    auto size = std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+    if (std::strtod(buffer, nullptr) != value) {
+        size = std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    }
+    out.append(buffer, static_cast<std::size_t>(size));
+}
+
+template <typename Value>
+void append_prometheus_sample(
+    std::string& out,
+    std::string_view prefix,
+    std::string_view name,
+    std::string_view procedure,
+    std::string_view le,
+    Value value)
+{
+    out.append(prefix).append(name);
+    if (!procedure.empty() || !le.empty()) {
+        out += '{';
+        if (!procedure.empty()) {
+            out += "procedure=\"";
+            append_prometheus_label(out, procedure);
+            out += '"';
+        }
+        if (!le.empty()) {
+            out += procedure.empty() ? "le=\"" : ",le=\"";
+            out.append(le);
+            out += '"';
+        }
+        out += '}';
+    }
+    out += ' ';
+    append_prometheus_number(out, value);
+    out += '\n';
+}
+
+inline void append_prometheus_header(
+    std::string& out,
+    std::string_view prefix,
+    std::string_view name,
+    std::string_view type,
+    std::string_view help)
+{
+    out.append("# HELP ").append(prefix).append(name);
+    out.append(" ").append(help).append("\n");
+    out.append("# TYPE ").append(prefix).append(name);
+    out.append(" ").append(type).append("\n");
+}
+
+} // internal
+
+//! Append the metrics of procedures to a string, in the Prometheus text format
+//!
+//! Latencies are exported in seconds, as histograms with a bucket for
+//! each power of four from 1 microsecond to 17 seconds.
+//! @param out The string to append to
+//! @param procedures The metrics of the procedures, see @ref dispatcher::metrics
+//! @param prefix The prefix of the names of the metrics
+inline void write_prometheus(
+    std::string& out,
+    const std::vector<procedure_metrics_snapshot>& procedures,
+    std::string_view prefix = "packio_")
+{
+    using internal::append_prometheus_header;
+    using internal::append_prometheus_sample;
+
+    append_prometheus_header(
+        out, prefix, "procedure_calls_total", "counter", "Completed calls.");
+    for (const auto& procedure : procedures) {
+        append_prometheus_sample(
+            out,
+            prefix,
+            "procedure_calls_total",
+            procedure.name,
+            {},
+            procedure.calls);
+    }
+    append_prometheus_header(
+        out,
+        prefix,
+        "procedure_errors_total",
+        "counter",
+        "Calls completed with an error.");
+    for (const auto& procedure : procedures) {
+        append_prometheus_sample(
+            out,
+            prefix,
+            "procedure_errors_total",
+            procedure.name,
+            {},
+            procedure.errors);
+    }
+
+    struct histogram_field {
+        std::string_view name;
+        std::string_view help;
+        histogram_snapshot procedure_metrics_snapshot::*member;
+    };
+    constexpr histogram_field histograms[] = {
+        {"procedure_queue_seconds",
+         "Time from the reception of the request to the start of the procedure.",
+         &procedure_metrics_snapshot::queue_time},
+        {"procedure_execution_seconds",
+         "Time from the start of the procedure to its completion.",
+         &procedure_metrics_snapshot::execution_time},
+        {"procedure_write_seconds",
+         "Time from the completion of the procedure to the end of the write.",
+         &procedure_metrics_snapshot::write_time},
+    };
+    constexpr unsigned kFirstExponent = 10; // ~1us
+    constexpr unsigned kLastExponent = 34; // ~17s
+
+    for (const auto& field : histograms) {
+        append_prometheus_header(out, prefix, field.name, "histogram", field.help);
+        std::string bucket_name{field.name};
+        bucket_name += "_bucket";
+        std::string sum_name{field.name};
+        sum_name += "_sum";
+        std::string count_name{field.name};
+        count_name += "_count";
+
+        for (const auto& procedure : procedures) {
+            const auto& histogram = procedure.*field.member;
+            for (auto exp = kFirstExponent; exp <= kLastExponent; exp += 2) {
+                std::string le;
+                internal::append_prometheus_number(
+                    le, static_cast<double>(std::uint64_t{1} << exp) / 1e9);
+                append_prometheus_sample(
+                    out,
+                    prefix,
+                    bucket_name,
+                    procedure.name,
+                    le,
+                    histogram.count_below_power_of_two(exp));
+            }
+            append_prometheus_sample(
+                out,
+                prefix,
+                bucket_name,
+                procedure.name,
+                "+Inf",
+                histogram.count);
+            append_prometheus_sample(
+                out,
+                prefix,
+                sum_name,
+                procedure.name,
+                {},
+                static_cast<double>(histogram.sum) / 1e9);
+            append_prometheus_sample(
+                out,
+                prefix,
+                count_name,
+                procedure.name,
+                {},
+                histogram.count);
+        }
+    }
+}
+
+//! Append the traffic of sessions to a string, in the Prometheus text format
+//! @param out The string to append to
+//! @param sessions The traffic of the sessions, see @ref server::get_session_metrics
+//! @param prefix The prefix of the names of the metrics
+inline void write_prometheus(
+    std::string& out,
+    const session_metrics_snapshot& sessions,
+    std::string_view prefix = "packio_")
+{
+    using internal::append_prometheus_header;
+    using internal::append_prometheus_sample;
+
+    append_prometheus_header(
+        out, prefix, "session_bytes_in_total", "counter", "Bytes read.");
+    append_prometheus_sample(
+        out,
+        prefix,
+        "session_bytes_in_total",
+        {},
+        {},
+        sessions.bytes_in);
+    append_prometheus_header(
+        out, prefix, "session_bytes_out_total", "counter", "Bytes written.");
+    append_prometheus_sample(
+        out,
+        prefix,
+        "session_bytes_out_total",
+        {},
+        {},
+        sessions.bytes_out);
+    append_prometheus_header(
+        out,
+        prefix,
+        "session_messages_in_total",
+        "counter",
+        "Requests and notifications read.");
+    append_prometheus_sample(
+        out,
+        prefix,
+        "session_messages_in_total",
+        {},
+        {},
+        sessions.messages_in);
+    append_prometheus_header(
+        out, prefix, "session_messages_out_total", "counter", "Responses written.");
+    append_prometheus_sample(
+        out,
+        prefix,
+        "session_messages_out_total",
+        {},
+        {},
+        sessions.messages_out);
+}
+
+} // packio
+
+#endif // PACKIO_METRICS_H
@@ -9,7 +9,9 @@
 //! Typedefs and functions to use the msgpack-RPC protocol
 
 #include "../client.h"
+#include "../client_pool.h"
 #include "../server.h"
+#include "../server_pool.h"
 #include "rpc.h"
 
 //! @namespace packio::msgpack_rpc
@@ -35,6 +37,21 @@ auto make_client(Socket&& socket)
     return std::make_shared<client<Socket, Map>>(std::forward<Socket>(socket));
 }
 
+//! The @ref packio::client_pool "client_pool" for msgpack-RPC
+template <typename Socket, template <class...> class Map = default_map>
+using client_pool = ::packio::client_pool<rpc, Socket, Map>;
+
+//! The @ref packio::make_client_pool "make_client_pool" function for msgpack-RPC
+template <
+    typename Socket,
+    template <class...> class Map = default_map,
+    typename ExecutorOrContext>
+auto make_client_pool(ExecutorOrContext&& context, std::size_t size)
+{
+    return ::packio::make_client_pool<rpc, Socket, Map>(
+        std::forward<ExecutorOrContext>(context), size);
+}
+
 //! The @ref packio::server "server" for msgpack-RPC
 template <typename Acceptor, typename Dispatcher = dispatcher<>>
 using server = ::packio::server<rpc, Acceptor, Dispatcher>;
@@ -47,6 +64,10 @@ auto make_server(Acceptor&& acceptor)
         std::forward<Acceptor>(acceptor));
 }
 
+//! The @ref packio::server_pool "server_pool" for msgpack-RPC
+template <typename Acceptor, typename Dispatcher = dispatcher<>>
+using server_pool = ::packio::server_pool<rpc, Acceptor, Dispatcher>;
+
 } // msgpack_rpc
 } // packio
 
@@ -5,7 +5,10 @@
 #ifndef PACKIO_MSGPACK_RPC_RPC_H
 #define PACKIO_MSGPACK_RPC_RPC_H
 
+#include <cstdint>
 #include <optional>
+#include <string_view>
+#include <vector>
 
 #include <msgpack.hpp>
 
@@ -34,10 +37,17 @@ using packio::internal::unexpected;
 struct request {
     call_type type;
     id_type id;
-    std::string method;
+    std::string_view method; //!< Procedure name, stored in the zone
+    //! Numeric ID sent instead of the method name, see dispatcher::freeze
+    std::optional<std::uint64_t> method_id;
     native_type args;
+    //! Number of requests of the batch starting with this request, always 0
+    std::size_t batch_size{0};
+    //! Why the request is invalid, always empty: msgpack-RPC has no batch
+    //! whose invalid members must be answered
+    std::string invalid;
 
-    std::unique_ptr<::msgpack::zone> zone; //!< Msgpack zone storing the args
+    std::unique_ptr<::msgpack::zone> zone; //!< Msgpack zone storing the method and the args
 };
 
 //! The object representing the response to a call
@@ -49,6 +59,12 @@ struct response {
     std::unique_ptr<::msgpack::zone> zone; //!< Msgpack zone storing error and result
 };
 
+//! The pre-encoded part of the requests to a procedure
+struct prepared_request {
+    std::string method; //!< The procedure name
+    std::string packed_method; //!< The procedure name, encoded
+};
+
 //! The incremental parser for msgpack-RPC objects
 class incremental_parser {
 public:
@@ -90,6 +106,20 @@ public:
 
     void reserve_buffer(std::size_t bytes) { unpacker_->reserve_buffer(bytes); }
 
+    //! Size of the received data not forming a complete message yet
+    std::size_t unparsed_size() const { return unpacker_->nonparsed_size(); }
+
+    //! Release the buffer capacity if it holds no partial message
+    void shrink_buffer()
+    {
+        if (unparsed_size() > 0) {
+            return;
+        }
+        // the unpacker cannot shrink its buffer, parsed objects keep
+        // a reference to the buffer they were read from through their zone
+        unpacker_ = std::make_unique<::msgpack::unpacker>();
+    }
+
 private:
     void try_parse_object()
     {
@@ -171,7 +201,12 @@ private:
                     "unexpected message size: " + std::to_string(array_size)};
             }
 
-            parsed.method = array[idx++].as<std::string>();
+            if (array[idx].type == ::msgpack::type::POSITIVE_INTEGER) {
+                parsed.method_id = array[idx++].as<std::uint64_t>();
+            }
+            else {
+                parsed.method = array[idx++].as<std::string_view>();
+            }
             parsed.args = array[idx++];
 
             return {std::move(parsed)};
@@ -206,11 +241,19 @@ public:
     //! The incremental parser type
     using incremental_parser_type = internal::incremental_parser;
 
+    //! The type of the pre-encoded part of a request
+    using prepared_request_type = internal::prepared_request;
+
     static std::string format_id(const id_type& id)
     {
         return std::to_string(id);
     }
 
+    static std::optional<std::uint64_t> integer_id(const id_type& id)
+    {
+        return id;
+    }
+
     template <typename... Args>
     static auto serialize_notification(std::string_view method, Args&&... args)
         -> std::enable_if_t<internal::positional_args_v<Args...>, ::msgpack::sbuffer>
@@ -258,6 +301,48 @@ public:
             "msgpack-RPC does not support named arguments");
     }
 
+    static prepared_request_type prepare_request(std::string_view method)
+    {
+        ::msgpack::sbuffer buffer;
+        ::msgpack::pack(buffer, method);
+        return {std::string{method}, std::string{buffer.data(), buffer.size()}};
+    }
+
+    static prepared_request_type prepare_request(
+        std::string_view method,
+        std::uint64_t method_id)
+    {
+        ::msgpack::sbuffer buffer;
+        ::msgpack::pack(buffer, method_id);
+        return {std::string{method}, std::string{buffer.data(), buffer.size()}};
+    }
+
+    template <typename... Args>
+    static auto serialize_request(
+        id_type id,
+        const prepared_request_type& request,
+        Args&&... args)
+        -> std::enable_if_t<internal::positional_args_v<Args...>, ::msgpack::sbuffer>
+    {
+        ::msgpack::sbuffer buffer;
+        ::msgpack::packer<::msgpack::sbuffer> packer{buffer};
+        packer.pack_array(4);
+        packer.pack(static_cast<int>(internal::msgpack_rpc_type::request));
+        packer.pack(id);
+        buffer.write(request.packed_method.data(), request.packed_method.size());
+        packer.pack(std::forward_as_tuple(std::forward<Args>(args)...));
+        return buffer;
+    }
+
+    template <typename... Args>
+    static auto serialize_request(id_type, const prepared_request_type&, Args&&...)
+        -> std::enable_if_t<!internal::positional_args_v<Args...>, ::msgpack::sbuffer>
+    {
+        static_assert(
+            internal::positional_args_v<Args...>,
+            "msgpack-RPC does not support named arguments");
+    }
+
     static ::msgpack::sbuffer serialize_response(id_type id)
     {
         return serialize_response(id, ::msgpack::object{});
@@ -277,6 +362,62 @@ public:
         return buffer;
     }
 
+    //! Serialize the arguments of a request, two requests with the same
+    //! arguments have the same serialized arguments
+    static std::string serialize_args(const native_type& args)
+    {
+        ::msgpack::sbuffer buffer;
+        ::msgpack::pack(buffer, args);
+        return std::string{buffer.data(), buffer.size()};
+    }
+
+    //! Serialize a result independently of the request it answers, see
+    //! @ref serialize_serialized_response
+    template <typename T>
+    static std::string serialize_result(T&& value)
+    {
+        ::msgpack::sbuffer buffer;
+        ::msgpack::pack(buffer, std::forward<T>(value));
+        return std::string{buffer.data(), buffer.size()};
+    }
+
+    //! Serialize an error independently of the request it answers, see
+    //! @ref serialize_serialized_response
+    template <typename T>
+    static std::string serialize_error(T&& value)
+    {
+        return serialize_result(std::forward<T>(value));
+    }
+
+    //! Serialize a response from a result serialized with @ref serialize_result,
+    //! or from an error serialized with @ref serialize_error
+    static ::msgpack::sbuffer serialize_serialized_response(
+        id_type id,
+        std::string_view result,
+        bool error = false)
+    {
+        ::msgpack::sbuffer buffer;
+        ::msgpack::packer<::msgpack::sbuffer> packer{buffer};
+        packer.pack_array(4);
+        packer.pack(static_cast<int>(internal::msgpack_rpc_type::response));
+        packer.pack(id);
+        if (error) {
+            buffer.write(result.data(), result.size());
+            packer.pack_nil();
+        }
+        else {
+            packer.pack_nil();
+            buffer.write(result.data(), result.size());
+        }
+        return buffer;
+    }
+
+    //! Serialize the error answering an invalid request
+    static ::msgpack::sbuffer serialize_invalid_request_response(id_type id)
+    {
+        return serialize_error_response(id, "invalid request");
+    }
+
     template <typename T>
     static ::msgpack::sbuffer serialize_error_response(id_type id, T&& value)
     {
@@ -291,6 +432,49 @@ public:
         return buffer;
     }
 
+    //! Convert the result of a call
+    //! @return The converted result, or the error returned by the procedure
+    template <typename T>
+    static internal::expected<T, call_error> extract_result(
+        const response_type& response)
+    {
+        try {
+            if (response.error.type != ::msgpack::type::NIL) {
+                if (response.error.type == ::msgpack::type::STR) {
+                    return internal::unexpected{
+                        call_error{response.error.as<std::string>()}};
+                }
+                return internal::unexpected{call_error{"unknown error"}};
+            }
+            return response.result.as<T>();
+        }
+        catch (const ::msgpack::type_error& exc) {
+            return internal::unexpected{
+                call_error{std::string{"cannot convert result: "} + exc.what()}};
+        }
+    }
+
+    //! Serialize several messages in a single buffer
+    //!
+    //! msgpack-RPC has no batch semantics, messages are concatenated
+    //! and handled individually by the peer.
+    static ::msgpack::sbuffer serialize_batch(
+        std::vector<::msgpack::sbuffer>&& messages)
+    {
+        if (messages.size() == 1) {
+            return std::move(messages.front());
+        }
+        std::size_t size = 0;
+        for (const auto& message : messages) {
+            size += message.size();
+        }
+        ::msgpack::sbuffer batch{size};
+        for (const auto& message : messages) {
+            batch.write(message.data(), message.size());
+        }
+        return batch;
+    }
+
     static net::const_buffer buffer(const ::msgpack::sbuffer& buf)
     {
         return net::const_buffer(buf.data(), buf.size());
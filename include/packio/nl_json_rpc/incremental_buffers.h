@@ -22,6 +22,11 @@ public:
         return serialized_objects_.size();
     }
 
+    std::size_t unparsed_size() const
+    { //
+        return buffer_.size();
+    }
+
     std::optional<std::string> get_parsed_buffer()
     {
         if (serialized_objects_.empty()) {
@@ -66,6 +71,16 @@ public:
         raw_buffer_.resize(buffer_.size() + bytes);
     }
 
+    void shrink_in_place_buffer()
+    {
+        if (!buffer_.empty()) {
+            return;
+        }
+        raw_buffer_.clear();
+        raw_buffer_.shrink_to_fit();
+        buffer_ = std::string_view{raw_buffer_.data(), 0};
+    }
+
 private:
     void incremental_parse(std::size_t bytes)
     {
@@ -115,8 +130,15 @@ private:
                         raw_buffer_.begin() + object_size + bytes_left,
                         raw_buffer_.begin());
                     buffer_ = std::string_view{raw_buffer_.data(), bytes_left};
-                    token_pos -= object_size;
-                    search_pos -= object_size;
+
+                    // the next value may be an object or an array (batch)
+                    auto next_pos = buffer_.find_first_of("{[");
+                    if (next_pos == std::string::npos) {
+                        buffer_ = std::string_view{raw_buffer_.data(), 0};
+                        break;
+                    }
+                    initialize(buffer_[next_pos]);
+                    search_pos = next_pos;
                 }
             }
             else {
@@ -6,6 +6,8 @@
 #define PACKIO_NL_JSON_RPC_RPC_H
 
 #include <array>
+#include <cstdint>
+#include <deque>
 #include <optional>
 
 #include <nlohmann/json.hpp>
@@ -38,7 +40,14 @@ struct request {
     call_type type;
     internal::id_type id;
     std::string method;
+    //! Numeric ID sent instead of the method name, see dispatcher::freeze
+    std::optional<std::uint64_t> method_id;
     native_type args;
+    //! Number of requests of the batch starting with this request, 0 otherwise
+    std::size_t batch_size{0};
+    //! Why the request is invalid, empty if it is valid. Invalid requests
+    //! are answered with an Invalid Request error
+    std::string invalid;
 };
 
 //! The object representing the response to a call
@@ -48,29 +57,53 @@ struct response {
     native_type error;
 };
 
+//! The pre-encoded part of the requests to a procedure
+struct prepared_request {
+    std::string method; //!< The procedure name
+    std::string header; //!< Encoded request, up to the params value
+};
+
 //! The incremental parser for JSON-RPC objects
 class incremental_parser {
 public:
     expected<request, std::string> get_request()
     {
-        try_parse_object();
-        if (!parsed_) {
-            return unexpected{"no request parsed"};
+        if (requests_.empty()) {
+            try_parse_object();
+            if (!parsed_) {
+                return unexpected{"no request parsed"};
+            }
+            auto object = std::move(*parsed_);
+            parsed_.reset();
+            if (!object.is_array()) {
+                return parse_request(std::move(object));
+            }
+            parse_request_batch(std::move(object));
         }
-        auto object = std::move(*parsed_);
-        parsed_.reset();
-        return parse_request(std::move(object));
+        auto request = std::move(requests_.front());
+        requests_.pop_front();
+        return {std::move(request)};
     }
 
     expected<response, std::string> get_response()
     {
-        try_parse_object();
-        if (!parsed_) {
-            return unexpected{"no response parsed"};
+        if (responses_.empty()) {
+            try_parse_object();
+            if (!parsed_) {
+                return unexpected{"no response parsed"};
+            }
+            auto object = std::move(*parsed_);
+            parsed_.reset();
+            if (!object.is_array()) {
+                return parse_response(std::move(object));
+            }
+            if (!parse_response_batch(std::move(object))) {
+                return unexpected{"empty batch"};
+            }
         }
-        auto object = std::move(*parsed_);
-        parsed_.reset();
-        return parse_response(std::move(object));
+        auto response = std::move(responses_.front());
+        responses_.pop_front();
+        return {std::move(response)};
     }
 
     char* buffer()
@@ -93,6 +126,18 @@ public:
         incremental_buffers_.reserve_in_place_buffer(bytes);
     }
 
+    //! Size of the received data not forming a complete message yet
+    std::size_t unparsed_size() const
+    { //
+        return incremental_buffers_.unparsed_size();
+    }
+
+    //! Release the buffer capacity if it holds no partial message
+    void shrink_buffer()
+    { //
+        incremental_buffers_.shrink_in_place_buffer();
+    }
+
 private:
     void try_parse_object()
     {
@@ -105,8 +150,68 @@ private:
         }
     }
 
+    void parse_request_batch(nlohmann::json&& batch)
+    {
+        // an empty batch is answered with a single error, not a batch
+        if (batch.empty()) {
+            requests_.push_back(invalid_request("empty batch"));
+            return;
+        }
+        auto first = requests_.size();
+        for (auto& item : batch) {
+            auto request = parse_request(std::move(item));
+            if (!request) {
+                PACKIO_INFO("invalid request in batch: {}", request.error());
+                requests_.push_back(invalid_request(
+                    std::move(request.error()), invalid_request_id(item)));
+                continue;
+            }
+            requests_.push_back(std::move(*request));
+        }
+        requests_[first].batch_size = requests_.size() - first;
+    }
+
+    static request invalid_request(std::string reason, id_type id = nullptr)
+    {
+        request invalid;
+        invalid.type = call_type::request;
+        invalid.id = std::move(id);
+        invalid.invalid = std::move(reason);
+        return invalid;
+    }
+
+    //! The id of an invalid request if it is a string or a number, null otherwise
+    static id_type invalid_request_id(const nlohmann::json& req)
+    {
+        if (!req.is_object()) {
+            return nullptr;
+        }
+        auto id_it = req.find("id");
+        if (id_it == end(req)
+            || !(id_it->is_string() || id_it->is_number())) {
+            return nullptr;
+        }
+        return *id_it;
+    }
+
+    bool parse_response_batch(nlohmann::json&& batch)
+    {
+        for (auto& item : batch) {
+            auto response = parse_response(std::move(item));
+            if (!response) {
+                PACKIO_INFO("invalid response in batch: {}", response.error());
+                continue;
+            }
+            responses_.push_back(std::move(*response));
+        }
+        return !responses_.empty();
+    }
+
     static expected<response, std::string> parse_response(nlohmann::json&& res)
     {
+        if (!res.is_object()) {
+            return unexpected{"response is not an object"};
+        }
         auto id_it = res.find("id");
         auto result_it = res.find("result");
         auto error_it = res.find("error");
@@ -131,6 +236,9 @@ private:
 
     static expected<request, std::string> parse_request(nlohmann::json&& req)
     {
+        if (!req.is_object()) {
+            return unexpected{"request is not an object"};
+        }
         auto id_it = req.find("id");
         auto method_it = req.find("method");
         auto params_it = req.find("params");
@@ -138,12 +246,19 @@ private:
         if (method_it == end(req)) {
             return unexpected{"missing method field"};
         }
-        if (!method_it->is_string()) {
+        // unsigned integer methods are numeric method IDs, an extension
+        // to JSON-RPC only used by clients that negotiated them
+        if (!method_it->is_string() && !method_it->is_number_unsigned()) {
             return unexpected{"method field is not a string"};
         }
 
         request parsed;
-        parsed.method = method_it->get<std::string>();
+        if (method_it->is_number_unsigned()) {
+            parsed.method_id = method_it->get<std::uint64_t>();
+        }
+        else {
+            parsed.method = method_it->get<std::string>();
+        }
         if (params_it == end(req) || params_it->is_null()) {
             parsed.args = nlohmann::json::array();
         }
@@ -165,6 +280,8 @@ private:
     }
 
     std::optional<nlohmann::json> parsed_;
+    std::deque<request> requests_;
+    std::deque<response> responses_;
     incremental_buffers incremental_buffers_;
 };
 
@@ -188,11 +305,25 @@ public:
     //! The incremental parser type
     using incremental_parser_type = internal::incremental_parser;
 
+    //! The type of the pre-encoded part of a request
+    using prepared_request_type = internal::prepared_request;
+
     static std::string format_id(const id_type& id)
     { //
         return id.dump();
     }
 
+    static std::optional<std::uint64_t> integer_id(const id_type& id)
+    {
+        if (id.is_number_unsigned()) {
+            return id.get<std::uint64_t>();
+        }
+        if (id.is_number_integer() && id.get<std::int64_t>() >= 0) {
+            return static_cast<std::uint64_t>(id.get<std::int64_t>());
+        }
+        return std::nullopt;
+    }
+
     template <typename... Args>
     static auto serialize_notification(std::string_view method, Args&&... args)
         -> std::enable_if_t<internal::positional_args_v<Args...>, std::string>
@@ -274,6 +405,45 @@ public:
             "JSON-RPC does not support mixed named and unnamed arguments");
     }
 
+    static prepared_request_type prepare_request(std::string_view method)
+    {
+        return {
+            std::string{method},
+            "{\"jsonrpc\":\"2.0\",\"method\":" + nlohmann::json(method).dump()
+                + ",\"params\":",
+        };
+    }
+
+    static prepared_request_type prepare_request(
+        std::string_view method,
+        std::uint64_t method_id)
+    {
+        return {
+            std::string{method},
+            "{\"jsonrpc\":\"2.0\",\"method\":" + std::to_string(method_id)
+                + ",\"params\":",
+        };
+    }
+
+    template <typename... Args>
+    static std::string serialize_request(
+        const id_type& id,
+        const prepared_request_type& request,
+        Args&&... args)
+    {
+        auto params = serialize_params(std::forward<Args>(args)...);
+        auto id_str = id.dump();
+
+        std::string res;
+        res.reserve(request.header.size() + params.size() + id_str.size() + 7);
+        res += request.header;
+        res += params;
+        res += ",\"id\":";
+        res += id_str;
+        res += '}';
+        return res;
+    }
+
     static std::string serialize_response(const id_type& id)
     {
         return serialize_response(id, nlohmann::json{});
@@ -290,30 +460,114 @@ public:
             .dump();
     }
 
+    //! Serialize the arguments of a request, two requests with the same
+    //! arguments have the same serialized arguments
+    static std::string serialize_args(const native_type& args)
+    {
+        return args.dump();
+    }
+
+    //! Serialize a result independently of the request it answers, see
+    //! @ref serialize_serialized_response
+    template <typename T>
+    static std::string serialize_result(T&& value)
+    {
+        return nlohmann::json(std::forward<T>(value)).dump();
+    }
+
+    //! Serialize an error independently of the request it answers, see
+    //! @ref serialize_serialized_response
+    template <typename T>
+    static std::string serialize_error(T&& value)
+    {
+        return make_error(std::forward<T>(value)).dump();
+    }
+
+    //! Serialize a response from a result serialized with @ref serialize_result,
+    //! or from an error serialized with @ref serialize_error
+    static std::string serialize_serialized_response(
+        const id_type& id,
+        std::string_view result,
+        bool error = false)
+    {
+        auto id_str = id.dump();
+
+        std::string res;
+        res.reserve(result.size() + id_str.size() + 32);
+        res += "{\"jsonrpc\":\"2.0\",\"id\":";
+        res += id_str;
+        res += error ? ",\"error\":" : ",\"result\":";
+        res += result;
+        res += '}';
+        return res;
+    }
+
+    //! Serialize the Invalid Request error answering an invalid request
+    static std::string serialize_invalid_request_response(const id_type& id)
+    {
+        return nlohmann::json{
+            {"jsonrpc", "2.0"},
+            {"id", id},
+            {"error", {{"code", -32600}, {"message", "Invalid Request"}}},
+        }
+            .dump();
+    }
+
     template <typename T>
     static std::string serialize_error_response(const id_type& id, T&& value)
     {
         return nlohmann::json{
             {"jsonrpc", "2.0"},
             {"id", id},
-            {"error",
-             [&]() {
-                 nlohmann::json error = {
-                     {"code", -32000}, // -32000 is an implementation-defined error
-                     {"data", std::forward<T>(value)},
-                 };
-                 if (error["data"].is_string()) {
-                     error["message"] = error["data"];
-                 }
-                 else {
-                     error["message"] = "unknown error";
-                 }
-                 return error;
-             }()},
+            {"error", make_error(std::forward<T>(value))},
         }
             .dump();
     }
 
+    //! Convert the result of a call
+    //! @return The converted result, or the error returned by the procedure
+    template <typename T>
+    static internal::expected<T, call_error> extract_result(
+        const response_type& response)
+    {
+        if (!response.error.is_null()) {
+            auto message_it = response.error.find("message");
+            if (message_it != end(response.error) && message_it->is_string()) {
+                return internal::unexpected{
+                    call_error{message_it->get<std::string>()}};
+            }
+            return internal::unexpected{call_error{"unknown error"}};
+        }
+        try {
+            return response.result.get<T>();
+        }
+        catch (const nlohmann::json::exception& exc) {
+            return internal::unexpected{
+                call_error{std::string{"cannot convert result: "} + exc.what()}};
+        }
+    }
+
+    //! Serialize several messages as a JSON-RPC batch
+    static std::string serialize_batch(std::vector<std::string>&& messages)
+    {
+        std::size_t size = messages.size() + 1;
+        for (const auto& message : messages) {
+            size += message.size();
+        }
+
+        std::string batch;
+        batch.reserve(size);
+        batch.push_back('[');
+        for (const auto& message : messages) {
+            if (batch.size() > 1) {
+                batch.push_back(',');
+            }
+            batch += message;
+        }
+        batch.push_back(']');
+        return batch;
+    }
+
     static net::const_buffer buffer(const std::string& buf)
     {
         return net::const_buffer(buf.data(), buf.size());
@@ -342,6 +596,47 @@ public:
     }
 
 private:
+    template <typename T>
+    static nlohmann::json make_error(T&& value)
+    {
+        nlohmann::json error = {
+            {"code", -32000}, // -32000 is an implementation-defined error
+            {"data", std::forward<T>(value)},
+        };
+        if (error["data"].is_string()) {
+            error["message"] = error["data"];
+        }
+        else {
+            error["message"] = "unknown error";
+        }
+        return error;
+    }
+
+    template <typename... Args>
+    static auto serialize_params(Args&&... args)
+        -> std::enable_if_t<internal::positional_args_v<Args...>, std::string>
+    {
+        return nlohmann::json::array({nlohmann::json(std::forward<Args>(args))...})
+            .dump();
+    }
+
+    template <typename... Args>
+    static auto serialize_params(Args&&... args)
+        -> std::enable_if_t<internal::named_args_v<Args...>, std::string>
+    {
+        return nlohmann::json({{args.name, args.value}...}).dump();
+    }
+
+    template <typename... Args>
+    static auto serialize_params(Args&&...) -> std::enable_if_t<
+        !internal::positional_args_v<Args...> && !internal::named_args_v<Args...>,
+        std::string>
+    {
+        static_assert(
+            internal::positional_args_v<Args...> || internal::named_args_v<Args...>,
+            "JSON-RPC does not support mixed named and unnamed arguments");
+    }
+
     template <typename T, typename F>
     static constexpr T convert_positional_args(
         const nlohmann::json& array,
@@ -12,9 +12,12 @@
 
 #include "arg.h"
 #include "client.h"
+#include "client_pool.h"
 #include "dispatcher.h"
 #include "handler.h"
+#include "metrics.h"
 #include "server.h"
+#include "server_pool.h"
 
 #if PACKIO_HAS_MSGPACK
 #include "msgpack_rpc/msgpack_rpc.h"
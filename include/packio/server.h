@@ -8,11 +8,16 @@
 //! @file
 //! Class @ref packio::server "server"
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
 
 #include "dispatcher.h"
+#include "internal/codel.h"
 #include "internal/config.h"
 #include "internal/log.h"
+#include "internal/priority_scheduler.h"
+#include "internal/session_counters.h"
 #include "internal/utils.h"
 #include "server_session.h"
 #include "traits.h"
@@ -36,6 +41,7 @@ public:
     using socket_type = std::decay_t<decltype(
         std::declval<acceptor_type>().accept())>; //!< The connection socket type
     using session_type = server_session<rpc_type, socket_type, dispatcher_type>;
+    using clock_type = typename session_type::clock_type; //!< The clock used for timeouts
 
     using std::enable_shared_from_this<server<Rpc, Acceptor, Dispatcher>>::shared_from_this;
 
@@ -70,6 +76,175 @@ public:
     //! Get the executor associated with the object
     executor_type get_executor() { return acceptor().get_executor(); }
 
+    //! Set the maximum number of pending requests of the new sessions,
+    //! see server_session::set_max_pending_requests
+    void set_session_max_pending_requests(std::size_t count) noexcept
+    {
+        session_max_pending_requests_ = count;
+    }
+    //! Get the maximum number of pending requests of the new sessions
+    std::size_t get_session_max_pending_requests() const noexcept
+    {
+        return session_max_pending_requests_;
+    }
+
+    //! Set the maximum size of the queued responses of the new sessions,
+    //! see server_session::set_max_queued_response_bytes
+    void set_session_max_queued_response_bytes(std::size_t size) noexcept
+    {
+        session_max_queued_response_bytes_ = size;
+    }
+    //! Get the maximum size of the queued responses of the new sessions
+    std::size_t get_session_max_queued_response_bytes() const noexcept
+    {
+        return session_max_queued_response_bytes_;
+    }
+
+    //! Set the maximum number of sessions
+    //!
+    //! Connections accepted while this many sessions are alive are
+    //! closed immediately, and the server keeps accepting. Zero, the
+    //! default, disables the limit.
+    void set_max_sessions(std::size_t count) noexcept { max_sessions_ = count; }
+    //! Get the maximum number of sessions
+    std::size_t get_max_sessions() const noexcept { return max_sessions_; }
+
+    //! Set the idle timeout of the new sessions, see server_session::set_idle_timeout
+    void set_session_idle_timeout(typename clock_type::duration timeout) noexcept
+    {
+        session_idle_timeout_ = timeout;
+    }
+    //! Get the idle timeout of the new sessions
+    typename clock_type::duration get_session_idle_timeout() const noexcept
+    {
+        return session_idle_timeout_;
+    }
+
+    //! Set the read timeout of the new sessions, see server_session::set_read_timeout
+    void set_session_read_timeout(typename clock_type::duration timeout) noexcept
+    {
+        session_read_timeout_ = timeout;
+    }
+    //! Get the read timeout of the new sessions
+    typename clock_type::duration get_session_read_timeout() const noexcept
+    {
+        return session_read_timeout_;
+    }
+
+    //! Limit the rate of the requests of each new session, see
+    //! server_session::set_rate_limit
+    void set_session_rate_limit(double rate, std::size_t burst = 1) noexcept
+    {
+        session_rate_limit_ = rate;
+        session_rate_limit_burst_ = burst;
+    }
+    //! Get the number of requests allowed per second to each new session
+    double get_session_rate_limit() const noexcept { return session_rate_limit_; }
+    //! Get the number of requests allowed at once to each new session
+    std::size_t get_session_rate_limit_burst() const noexcept
+    {
+        return session_rate_limit_burst_;
+    }
+
+    //! Enable the load shedding of the new sessions
+    //!
+    //! The sessions of the server share a CoDel controller: each request
+    //! is timestamped when it is read, and its queueing delay is checked
+    //! when it is about to be executed. When the delay stayed above the
+    //! target for a whole interval, requests that waited longer than the
+    //! target are answered with server_session::kOverloadedError without
+    //! being executed, otherwise only those that waited longer than the
+    //! interval are. Only the queue of the executor of the sessions is
+    //! measured: inline procedures and procedures running on their own
+    //! executor are never shed.
+    //! @param target The acceptable queueing delay, zero disables the load shedding
+    //! @param interval The duration the delay must stay above the target
+    void set_load_shedding(
+        typename clock_type::duration target,
+        typename clock_type::duration interval = std::chrono::milliseconds{100})
+    {
+        if (target == clock_type::duration::zero()) {
+            codel_.reset();
+        }
+        else {
+            codel_ = std::make_shared<internal::codel>(target, interval);
+        }
+    }
+    //! Get the target queueing delay of the load shedding, zero if disabled
+    typename clock_type::duration get_load_shedding_target() const noexcept
+    {
+        return codel_ ? codel_->target() : clock_type::duration::zero();
+    }
+    //! Get the interval of the load shedding, zero if disabled
+    typename clock_type::duration get_load_shedding_interval() const noexcept
+    {
+        return codel_ ? codel_->interval() : clock_type::duration::zero();
+    }
+
+    //! Execute the requests of the new sessions by priority
+    //!
+    //! The sessions of the server share a scheduler: requests queued on
+    //! an executor run by order of priority class, see
+    //! dispatcher::set_priority, and in FIFO order within a class.
+    //! Requests of high priority procedures overtake the requests
+    //! already queued, but do not interrupt running ones. A request
+    //! always runs on the executor of its session, priorities apply
+    //! between the sessions running on the same executor. Procedures
+    //! added with their own executor, see dispatcher::add, are not
+    //! scheduled.
+    //! @param enabled True to schedule requests by priority
+    void set_priority_scheduling(bool enabled)
+    {
+        if (enabled && !scheduler_) {
+            scheduler_ =
+                std::make_shared<internal::priority_scheduler>(kPriorityClasses);
+        }
+        else if (!enabled) {
+            scheduler_.reset();
+        }
+    }
+    //! Check if the requests are executed by priority
+    bool get_priority_scheduling() const noexcept { return scheduler_ != nullptr; }
+
+    //! Get the number of sessions alive
+    std::size_t get_active_sessions() const noexcept
+    {
+        return counters_->active.load(std::memory_order_relaxed);
+    }
+    //! Get the number of connections accepted
+    std::uint64_t get_accepted_sessions() const noexcept
+    {
+        return counters_->accepted.load(std::memory_order_relaxed);
+    }
+    //! Get the number of connections closed because of the session limit
+    std::uint64_t get_rejected_sessions() const noexcept
+    {
+        return counters_->rejected.load(std::memory_order_relaxed);
+    }
+    //! Get the number of sessions closed because of a timeout
+    std::uint64_t get_timed_out_sessions() const noexcept
+    {
+        return counters_->timed_out.load(std::memory_order_relaxed);
+    }
+    //! Get the number of requests shed by the load shedding
+    std::uint64_t get_shed_requests() const noexcept
+    {
+        return counters_->shed.load(std::memory_order_relaxed);
+    }
+    //! Get the number of requests rejected by a rate limit
+    std::uint64_t get_rate_limited_requests() const noexcept
+    {
+        return counters_->rate_limited.load(std::memory_order_relaxed);
+    }
+
+#if PACKIO_HAS_METRICS
+    //! Get the traffic of all the sessions created by the server
+    session_metrics_snapshot get_session_metrics() const noexcept
+    {
+        return counters_->metrics.snapshot();
+    }
+#endif // PACKIO_HAS_METRICS
+
     //! Accept one connection and initialize a session for it
     //!
     //! @param handler Handler called when a connection is accepted.
@@ -116,30 +291,67 @@ private:
         {
             PACKIO_STATIC_ASSERT_TTRAIT(ServeHandler, session_type);
             PACKIO_TRACE("async_serve");
-
-            self_->acceptor_.async_accept(
-                [self = self_->shared_from_this(),
-                 handler = std::forward<ServeHandler>(handler)](
-                    error_code ec, socket_type sock) mutable {
-                    std::shared_ptr<session_type> session;
-                    if (ec) {
-                        PACKIO_WARN("accept error: {}", ec.message());
-                    }
-                    else {
-                        internal::set_no_delay(sock);
-                        session = std::make_shared<session_type>(
-                            std::move(sock), self->dispatcher_ptr_);
-                    }
-                    handler(ec, std::move(session));
-                });
+            self_->async_accept(std::forward<ServeHandler>(handler));
         }
 
     private:
         server* self_;
     };
 
+    template <typename ServeHandler>
+    void async_accept(ServeHandler&& handler)
+    {
+        acceptor_.async_accept(
+            [self = shared_from_this(),
+             handler = std::forward<ServeHandler>(handler)](
+                error_code ec, socket_type sock) mutable {
+                std::shared_ptr<session_type> session;
+                if (ec) {
+                    PACKIO_WARN("accept error: {}", ec.message());
+                }
+                else if (
+                    self->max_sessions_ > 0
+                    && self->counters_->active.load() >= self->max_sessions_) {
+                    PACKIO_INFO("too many sessions, connection rejected");
+                    ++self->counters_->rejected;
+                    error_code close_ec;
+                    sock.close(close_ec);
+                    self->async_accept(std::move(handler));
+                    return;
+                }
+                else {
+                    ++self->counters_->accepted;
+                    internal::set_no_delay(sock);
+                    session = std::make_shared<session_type>(
+                        std::move(sock), self->dispatcher_ptr_, self->counters_);
+                    session->set_idle_timeout(self->session_idle_timeout_);
+                    session->set_read_timeout(self->session_read_timeout_);
+                    session->set_max_pending_requests(
+                        self->session_max_pending_requests_);
+                    session->set_max_queued_response_bytes(
+                        self->session_max_queued_response_bytes_);
+                    session->set_load_shedding(self->codel_);
+                    session->set_priority_scheduler(self->scheduler_);
+                    session->set_rate_limit(
+                        self->session_rate_limit_, self->session_rate_limit_burst_);
+                }
+                handler(ec, std::move(session));
+            });
+    }
+
     acceptor_type acceptor_;
     std::shared_ptr<dispatcher_type> dispatcher_ptr_;
+    std::shared_ptr<internal::session_counters> counters_{
+        std::make_shared<internal::session_counters>()};
+    std::size_t max_sessions_{0};
+    typename clock_type::duration session_idle_timeout_{clock_type::duration::zero()};
+    typename clock_type::duration session_read_timeout_{clock_type::duration::zero()};
+    std::size_t session_max_pending_requests_{0};
+    std::size_t session_max_queued_response_bytes_{0};
+    std::shared_ptr<internal::codel> codel_;
+    std::shared_ptr<internal::priority_scheduler> scheduler_;
+    double session_rate_limit_{0.};
+    std::size_t session_rate_limit_burst_{1};
 };
 
 //! Create a server from an acceptor
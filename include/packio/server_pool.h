@@ -0,0 +1,370 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#ifndef PACKIO_SERVER_POOL_H
+#define PACKIO_SERVER_POOL_H
+
+//! @file
+//! Class @ref packio::server_pool "server_pool"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif // defined(__linux__)
+
+#include "dispatcher.h"
+#include "internal/config.h"
+#include "internal/log.h"
+#include "internal/utils.h"
+#include "server.h"
+
+namespace packio {
+
+#if defined(SO_REUSEPORT)
+//! The SO_REUSEPORT socket option
+//!
+//! Implements the SettableSocketOption requirements of the acceptor,
+//! use it with set_option.
+class reuse_port {
+public:
+    explicit reuse_port(bool enabled) noexcept : value_{enabled ? 1 : 0} {}
+
+    template <typename Protocol>
+    int level(const Protocol&) const noexcept
+    {
+        return SOL_SOCKET;
+    }
+
+    template <typename Protocol>
+    int name(const Protocol&) const noexcept
+    {
+        return SO_REUSEPORT;
+    }
+
+    template <typename Protocol>
+    const int* data(const Protocol&) const noexcept
+    {
+        return &value_;
+    }
+
+    template <typename Protocol>
+    std::size_t size(const Protocol&) const noexcept
+    {
+        return sizeof(value_);
+    }
+
+private:
+    int value_;
+};
+#endif // defined(SO_REUSEPORT)
+
+//! Create an acceptor that shares its endpoint with other acceptors
+//!
+//! The acceptor is opened with SO_REUSEPORT, so several acceptors,
+//! typically one per io_context of a @ref server_pool, can listen on
+//! the same endpoint and the kernel spreads the connections among them.
+//! Where SO_REUSEPORT is not available, only the first acceptor can
+//! bind the endpoint.
+//! @tparam Acceptor The acceptor type, a basic_socket_acceptor
+//! @param ctx The execution context or executor of the acceptor
+//! @param endpoint The endpoint to listen on
+template <typename Acceptor = net::ip::tcp::acceptor, typename ExecutorOrContext>
+Acceptor make_reuse_port_acceptor(
+    ExecutorOrContext&& ctx,
+    const typename Acceptor::endpoint_type& endpoint)
+{
+    Acceptor acceptor{std::forward<ExecutorOrContext>(ctx)};
+    acceptor.open(endpoint.protocol());
+    acceptor.set_option(typename Acceptor::reuse_address{true});
+#if defined(SO_REUSEPORT)
+    acceptor.set_option(reuse_port{true});
+#endif // defined(SO_REUSEPORT)
+    acceptor.bind(endpoint);
+    acceptor.listen();
+    return acceptor;
+}
+
+//! The server_pool class
+//!
+//! Runs several servers sharing a dispatcher, each one with its own
+//! io_context run by a dedicated thread. Sessions stay on the
+//! io_context of the server that accepted them, so threads do not
+//! contend on a shared scheduler queue. Acceptors are typically
+//! created with @ref make_reuse_port_acceptor to listen on the
+//! same endpoint.
+//! @tparam Rpc RPC protocol implementation
+//! @tparam Acceptor Acceptor type to use for the servers
+//! @tparam Dispatcher Dispatcher used to store and dispatch procedures. See @ref dispatcher
+template <typename Rpc, typename Acceptor, typename Dispatcher = dispatcher<Rpc>>
+class server_pool {
+public:
+    //! The server type
+    using server_type = server<Rpc, Acceptor, Dispatcher>;
+    using rpc_type = Rpc; //!< The RPC protocol type
+    using acceptor_type = Acceptor; //!< The acceptor type
+    using dispatcher_type = Dispatcher; //!< The dispatcher type
+
+    //! The constructor
+    //! @param size The number of servers, each with its own io_context
+    //! @param make_acceptor Callable creating the acceptor of a server
+    //! from its io_context, called in order for each server
+    //! @param dispatcher A shared pointer to the dispatcher used by all servers
+    template <typename AcceptorFactory>
+    server_pool(
+        std::size_t size,
+        AcceptorFactory&& make_acceptor,
+        std::shared_ptr<dispatcher_type> dispatcher)
+        : dispatcher_ptr_{std::move(dispatcher)}
+    {
+        assert(size > 0);
+        contexts_.reserve(size);
+        servers_.reserve(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            // each io_context is run by a single thread
+            contexts_.push_back(std::make_unique<net::io_context>(1));
+            servers_.push_back(std::make_shared<server_type>(
+                make_acceptor(*contexts_.back()), dispatcher_ptr_));
+        }
+    }
+
+    //! @overload
+    template <typename AcceptorFactory>
+    server_pool(std::size_t size, AcceptorFactory&& make_acceptor)
+        : server_pool{
+            size,
+            std::forward<AcceptorFactory>(make_acceptor),
+            std::make_shared<dispatcher_type>()}
+    {
+    }
+
+    server_pool(const server_pool&) = delete;
+    server_pool& operator=(const server_pool&) = delete;
+
+    //! The destructor, stops the io_contexts and joins the threads
+    ~server_pool()
+    {
+        stop();
+        join();
+    }
+
+    //! Get the servers of the pool
+    const std::vector<std::shared_ptr<server_type>>& servers() const noexcept
+    {
+        return servers_;
+    }
+
+    //! Get the number of servers in the pool
+    std::size_t size() const noexcept { return servers_.size(); }
+
+    //! Get the dispatcher shared by the servers
+    std::shared_ptr<dispatcher_type> dispatcher() { return dispatcher_ptr_; }
+    //! Get the dispatcher shared by the servers, const
+    std::shared_ptr<const dispatcher_type> dispatcher() const
+    {
+        return dispatcher_ptr_;
+    }
+
+    //! Get the io_context of a server
+    net::io_context& context(std::size_t index) { return *contexts_.at(index); }
+
+    //! Pin each thread to a CPU, server i running on CPU i modulo the
+    //! number of CPUs. Only supported on Linux. Must be set before @ref run.
+    void set_pin_threads(bool pin) noexcept { pin_threads_ = pin; }
+    //! Check if the threads are pinned to CPUs
+    bool get_pin_threads() const noexcept { return pin_threads_; }
+
+    //! Set the maximum number of pending requests of the new sessions
+    //! on all servers, see server::set_session_max_pending_requests
+    void set_session_max_pending_requests(std::size_t count) noexcept
+    {
+        for (auto& server : servers_) {
+            server->set_session_max_pending_requests(count);
+        }
+    }
+    //! Get the maximum number of pending requests of the new sessions
+    std::size_t get_session_max_pending_requests() const noexcept
+    {
+        return servers_.front()->get_session_max_pending_requests();
+    }
+
+    //! Set the maximum size of the queued responses of the new sessions
+    //! on all servers, see server::set_session_max_queued_response_bytes
+    void set_session_max_queued_response_bytes(std::size_t size) noexcept
+    {
+        for (auto& server : servers_) {
+            server->set_session_max_queued_response_bytes(size);
+        }
+    }
+    //! Get the maximum size of the queued responses of the new sessions
+    std::size_t get_session_max_queued_response_bytes() const noexcept
+    {
+        return servers_.front()->get_session_max_queued_response_bytes();
+    }
+
+    //! Enable the load shedding on all servers, see server::set_load_shedding
+    //!
+    //! Each server has its own controller, measuring the queue of its
+    //! own io_context.
+    void set_load_shedding(
+        typename server_type::clock_type::duration target,
+        typename server_type::clock_type::duration interval =
+            std::chrono::milliseconds{100})
+    {
+        for (auto& server : servers_) {
+            server->set_load_shedding(target, interval);
+        }
+    }
+
+    //! Limit the rate of the requests of each new session on all servers,
+    //! see server::set_session_rate_limit
+    void set_session_rate_limit(double rate, std::size_t burst = 1)
+    {
+        for (auto& server : servers_) {
+            server->set_session_rate_limit(rate, burst);
+        }
+    }
+
+    //! Execute the requests by priority on all servers, see
+    //! server::set_priority_scheduling
+    void set_priority_scheduling(bool enabled)
+    {
+        for (auto& server : servers_) {
+            server->set_priority_scheduling(enabled);
+        }
+    }
+
+    //! Accept connections and start the sessions forever on all servers
+    void async_serve_forever()
+    {
+        for (auto& server : servers_) {
+            server->async_serve_forever();
+        }
+    }
+
+    //! Start one thread per server, running its io_context
+    void run()
+    {
+        assert(threads_.empty());
+        threads_.reserve(contexts_.size());
+        for (std::size_t i = 0; i < contexts_.size(); ++i) {
+            threads_.emplace_back([this, i] {
+                if (pin_threads_) {
+                    pin_thread(i);
+                }
+                contexts_[i]->run();
+            });
+        }
+    }
+
+    //! Stop all the io_contexts
+    void stop()
+    {
+        for (auto& context : contexts_) {
+            context->stop();
+        }
+    }
+
+    //! Wait for all the threads to exit
+    void join()
+    {
+        for (auto& thread : threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+        threads_.clear();
+    }
+
+    //! Get the number of sessions alive on all servers
+    std::size_t get_active_sessions() const noexcept
+    {
+        std::size_t count = 0;
+        for (const auto& server : servers_) {
+            count += server->get_active_sessions();
+        }
+        return count;
+    }
+
+    //! Get the number of connections accepted by all servers
+    std::uint64_t get_accepted_sessions() const noexcept
+    {
+        std::uint64_t count = 0;
+        for (const auto& server : servers_) {
+            count += server->get_accepted_sessions();
+        }
+        return count;
+    }
+
+    //! Get the number of requests shed by all servers
+    std::uint64_t get_shed_requests() const noexcept
+    {
+        std::uint64_t count = 0;
+        for (const auto& server : servers_) {
+            count += server->get_shed_requests();
+        }
+        return count;
+    }
+
+    //! Get the number of requests rejected by a rate limit on all servers
+    std::uint64_t get_rate_limited_requests() const noexcept
+    {
+        std::uint64_t count = 0;
+        for (const auto& server : servers_) {
+            count += server->get_rate_limited_requests();
+        }
+        return count;
+    }
+
+#if PACKIO_HAS_METRICS
+    //! Get the traffic of all the sessions of all servers
+    session_metrics_snapshot get_session_metrics() const noexcept
+    {
+        session_metrics_snapshot total;
+        for (const auto& server : servers_) {
+            auto metrics = server->get_session_metrics();
+            total.bytes_in += metrics.bytes_in;
+            total.bytes_out += metrics.bytes_out;
+            total.messages_in += metrics.messages_in;
+            total.messages_out += metrics.messages_out;
+        }
+        return total;
+    }
+#endif // PACKIO_HAS_METRICS
+
+private:
+    static void pin_thread(std::size_t index)
+    {
+#if defined(__linux__)
+        auto n_cpus = std::max(1u, std::thread::hardware_concurrency());
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(index % n_cpus, &cpus);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+            PACKIO_WARN("cannot pin thread {} to a cpu", index);
+        }
+#else
+        (void)index;
+#endif // defined(__linux__)
+    }
+
+    std::shared_ptr<dispatcher_type> dispatcher_ptr_;
+    // destroyed after the servers, which use them
+    std::vector<std::unique_ptr<net::io_context>> contexts_;
+    std::vector<std::shared_ptr<server_type>> servers_;
+    std::vector<std::thread> threads_;
+    bool pin_threads_{false};
+};
+
+} // packio
+
+#endif // PACKIO_SERVER_POOL_H
@@ -8,14 +8,27 @@
 //! @file
 //! Class @ref packio::server_session "server_session"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <queue>
+#include <vector>
 
 #include "handler.h"
+#include "internal/buffer_reserve.h"
+#include "internal/codel.h"
 #include "internal/config.h"
 #include "internal/log.h"
 #include "internal/manual_strand.h"
+#include "internal/memo_cache.h"
+#include "internal/metrics.h"
+#include "internal/priority_scheduler.h"
 #include "internal/rpc.h"
+#include "internal/session_counters.h"
+#include "internal/token_bucket.h"
 #include "internal/utils.h"
 
 namespace packio {
@@ -31,17 +44,41 @@ public:
     using executor_type =
         typename socket_type::executor_type; //!< The executor type
 
+    using clock_type = std::chrono::steady_clock; //!< The clock used for timeouts
+
     using std::enable_shared_from_this<server_session<Rpc, Socket, Dispatcher>>::shared_from_this;
+    using std::enable_shared_from_this<server_session<Rpc, Socket, Dispatcher>>::weak_from_this;
 
     //! The default size reserved by the reception buffer
     static constexpr size_t kDefaultBufferReserveSize = 4096;
-
-    server_session(socket_type sock, std::shared_ptr<Dispatcher> dispatcher_ptr)
+    //! The default maximum size reserved by the reception buffer
+    static constexpr size_t kDefaultMaxBufferReserveSize = 65536;
+    //! The error returned for requests shed by the load shedding
+    static constexpr char kOverloadedError[] = "server overloaded";
+    //! The error returned for requests over a rate limit
+    static constexpr char kRateLimitedError[] = "rate limit exceeded";
+
+    server_session(
+        socket_type sock,
+        std::shared_ptr<Dispatcher> dispatcher_ptr,
+        std::shared_ptr<internal::session_counters> counters = nullptr)
         : socket_{std::move(sock)},
           dispatcher_ptr_{std::move(dispatcher_ptr)},
+          counters_{std::move(counters)},
           strand_(socket_.get_executor()),
-          wstrand_{strand_}
+          wstrand_{socket_, strand_},
+          timeout_timer_{socket_.get_executor()}
+    {
+        if (counters_) {
+            ++counters_->active;
+        }
+    }
+
+    ~server_session()
     {
+        if (counters_) {
+            --counters_->active;
+        }
     }
 
     //! Get the underlying socket
@@ -53,29 +90,221 @@ public:
     executor_type get_executor() { return socket().get_executor(); }
 
     //! Set the size reserved by the reception buffer
+    //!
+    //! This is the minimum size, the reservation grows up to
+    //! @ref set_max_buffer_reserve_size "the maximum size" while
+    //! reads fill it and shrinks back when they do not.
     void set_buffer_reserve_size(std::size_t size) noexcept
     {
-        buffer_reserve_size_ = size;
+        buffer_reserve_.set_min(size);
     }
     //! Get the size reserved by the reception buffer
     std::size_t get_buffer_reserve_size() const noexcept
     {
-        return buffer_reserve_size_;
+        return buffer_reserve_.get_min();
+    }
+
+    //! Set the maximum size reserved by the reception buffer
+    //!
+    //! The reservation doubles after each read that fills it, up to this
+    //! size, so large requests are received with fewer reads. A value not
+    //! larger than the buffer reserve size disables the adaptation.
+    void set_max_buffer_reserve_size(std::size_t size) noexcept
+    {
+        buffer_reserve_.set_max(size);
+    }
+    //! Get the maximum size reserved by the reception buffer
+    std::size_t get_max_buffer_reserve_size() const noexcept
+    {
+        return buffer_reserve_.get_max();
+    }
+
+    //! Set the maximum number of bytes gathered in a single write
+    //!
+    //! Responses queued while a write is in progress are gathered
+    //! into a single write, up to this size. A single response
+    //! larger than this size is still written.
+    void set_max_write_size(std::size_t size) noexcept
+    {
+        wstrand_.set_max_write_size(size);
+    }
+    //! Get the maximum number of bytes gathered in a single write
+    std::size_t get_max_write_size() const noexcept
+    {
+        return wstrand_.get_max_write_size();
+    }
+
+    //! Set the maximum number of responses gathered in a single write
+    void set_max_write_buffers(std::size_t count) noexcept
+    {
+        wstrand_.set_max_write_buffers(count);
+    }
+    //! Get the maximum number of responses gathered in a single write
+    std::size_t get_max_write_buffers() const noexcept
+    {
+        return wstrand_.get_max_write_buffers();
+    }
+
+    //! Set the maximum number of pending requests
+    //!
+    //! Requests are pending from the moment they are read until their
+    //! procedure completes. When this many requests are pending, the
+    //! session stops reading, so the peer is slowed down by the flow
+    //! control of the transport. Zero, the default, disables the limit.
+    //! Must be set before starting the session.
+    void set_max_pending_requests(std::size_t count) noexcept
+    {
+        max_pending_requests_ = count;
+    }
+    //! Get the maximum number of pending requests
+    std::size_t get_max_pending_requests() const noexcept
+    {
+        return max_pending_requests_;
+    }
+
+    //! Set the maximum size of the responses waiting to be written
+    //!
+    //! When the responses waiting to be written reach this size, the
+    //! session stops reading until they are written. Zero, the default,
+    //! disables the limit. Must be set before starting the session.
+    void set_max_queued_response_bytes(std::size_t size) noexcept
+    {
+        max_queued_response_bytes_ = size;
+    }
+    //! Get the maximum size of the responses waiting to be written
+    std::size_t get_max_queued_response_bytes() const noexcept
+    {
+        return max_queued_response_bytes_;
     }
 
+    //! Set the idle timeout
+    //!
+    //! The session is closed when it has no request pending and has
+    //! received nothing for this duration. Zero, the default, disables
+    //! the timeout. Must be set before starting the session.
+    void set_idle_timeout(clock_type::duration timeout) noexcept
+    {
+        idle_timeout_ = timeout;
+    }
+    //! Get the idle timeout
+    clock_type::duration get_idle_timeout() const noexcept
+    {
+        return idle_timeout_;
+    }
+
+    //! Set the read timeout
+    //!
+    //! The session is closed when a request has been partially received
+    //! and nothing more is received for this duration. Zero, the default,
+    //! disables the timeout. Must be set before starting the session.
+    void set_read_timeout(clock_type::duration timeout) noexcept
+    {
+        read_timeout_ = timeout;
+    }
+    //! Get the read timeout
+    clock_type::duration get_read_timeout() const noexcept
+    {
+        return read_timeout_;
+    }
+
+    //! Limit the rate of the requests of the session
+    //!
+    //! Requests received when the token bucket of the session is empty
+    //! are answered with @ref kRateLimitedError immediately, without
+    //! being dispatched. Procedures can also be limited by the
+    //! dispatcher, see dispatcher::set_rate_limit: a request rejected by
+    //! the limit of its procedure does not take a token of the session.
+    //! @param rate The number of requests allowed per second, zero, the
+    //! default, disables the limit
+    //! @param burst The number of requests allowed at once
+    void set_rate_limit(double rate, std::size_t burst = 1) noexcept
+    {
+        rate_limit_.set_rate(rate, burst);
+    }
+    //! Get the number of requests allowed per second, zero if unlimited
+    double get_rate_limit() const noexcept { return rate_limit_.rate(); }
+    //! Get the number of requests allowed at once
+    std::size_t get_rate_limit_burst() const noexcept
+    {
+        return rate_limit_.burst();
+    }
+
+    //! Set the load shedding controller
+    //!
+    //! The controller is usually shared by the sessions of a server, see
+    //! server::set_load_shedding. Requests that stayed too long in the
+    //! queue of the executor are answered with @ref kOverloadedError
+    //! instead of being executed. Null, the default, disables the load
+    //! shedding. Must be set before starting the session.
+    void set_load_shedding(std::shared_ptr<internal::codel> controller) noexcept
+    {
+        codel_ = std::move(controller);
+    }
+    //! Get the load shedding controller
+    const std::shared_ptr<internal::codel>& get_load_shedding() const noexcept
+    {
+        return codel_;
+    }
+
+    //! Set the scheduler executing the requests by priority
+    //!
+    //! The scheduler is usually shared by the sessions of a server, see
+    //! server::set_priority_scheduling. Null, the default, executes the
+    //! requests in FIFO order. Must be set before starting the session.
+    void set_priority_scheduler(
+        std::shared_ptr<internal::priority_scheduler> scheduler) noexcept
+    {
+        scheduler_ = std::move(scheduler);
+    }
+    //! Get the scheduler executing the requests by priority
+    const std::shared_ptr<internal::priority_scheduler>& get_priority_scheduler() const noexcept
+    {
+        return scheduler_;
+    }
+
+#if PACKIO_HAS_METRICS
+    //! Get the traffic of the session
+    session_metrics_snapshot get_metrics() const noexcept
+    {
+        session_metrics_snapshot snapshot;
+        metrics_.add_to(snapshot);
+        return snapshot;
+    }
+#endif // PACKIO_HAS_METRICS
+
     //! Start the session
     void start()
     {
         net::dispatch(strand_, [self = shared_from_this()]() {
-            self->async_read(parser_type{});
+            if (self->has_timeouts()) {
+                self->on_activity();
+                self->check_timeouts();
+            }
+            self->async_read();
         });
     }
 
 private:
     using parser_type = typename Rpc::incremental_parser_type;
     using request_type = typename Rpc::request_type;
+    using response_buffer_type =
+        typename completion_handler<Rpc>::response_buffer_type;
+    using procedure_ref = typename Dispatcher::procedure_ref;
+
+    //! Responses of a batch, sent together when all calls are complete
+    struct response_batch {
+        explicit response_batch(std::size_t size) : remaining{size}
+        {
+            responses.reserve(size);
+        }
 
-    void async_read(parser_type&& parser)
+        std::mutex mutex;
+        std::size_t remaining;
+        std::vector<response_buffer_type> responses;
+        internal::batch_call_metrics metrics;
+    };
+
+    void async_read()
     {
         assert(strand_.running_in_this_thread());
 
@@ -84,15 +313,19 @@ private:
             return;
         }
 
-        parser.reserve_buffer(buffer_reserve_size_);
-        auto buffer = net::buffer(parser.buffer(), parser.buffer_capacity());
+        if (release_buffer_) {
+            // release the capacity grown for larger requests
+            parser_.shrink_buffer();
+            release_buffer_ = false;
+        }
+        parser_.reserve_buffer(buffer_reserve_.size());
+        auto buffer = net::buffer(parser_.buffer(), parser_.buffer_capacity());
 
         socket_.async_read_some(
             buffer,
             internal::bind_executor(
                 strand_,
-                [self = shared_from_this(), parser = std::move(parser)](
-                    error_code ec, size_t length) mutable {
+                [self = shared_from_this()](error_code ec, size_t length) {
                     assert(self->strand_.running_in_this_thread());
 
                     if (ec) {
@@ -102,46 +335,396 @@ private:
                     }
 
                     PACKIO_TRACE("read: {}", length);
-                    parser.buffer_consumed(length);
-
-                    while (true) {
-                        auto request = parser.get_request();
-                        if (!request) {
-                            PACKIO_INFO("stop reading: {}", request.error());
-                            break;
-                        }
-                        // handle the call asynchronously (post)
-                        // to schedule the next read immediately
-                        // this will allow parallel call handling
-                        // in multi-threaded environments
-                        net::post(
-                            self->get_executor(),
-                            [self, request = std::move(*request)]() mutable {
-                                self->async_handle_request(std::move(request));
-                            });
+                    if (self->has_timeouts()) {
+                        self->on_activity();
                     }
-
-                    self->async_read(std::move(parser));
+                    self->on_bytes_read(length);
+                    self->parser_.buffer_consumed(length);
+                    if (self->buffer_reserve_.on_read(length)) {
+                        self->release_buffer_ = true;
+                    }
+                    self->handle_requests();
                 }));
     }
 
-    void async_handle_request(request_type&& request)
+    void handle_requests()
+    {
+        assert(strand_.running_in_this_thread());
+
+        // responses of inline procedures are written together
+        wstrand_.cork();
+        parse_requests();
+        wstrand_.uncork();
+    }
+
+    void parse_requests()
+    {
+        assert(strand_.running_in_this_thread());
+
+        while (true) {
+            // requests of a batch are handled together
+            if (batch_remaining_ == 0 && should_pause_reading()) {
+                PACKIO_DEBUG("pause reading");
+                return;
+            }
+
+            auto request = parser_.get_request();
+            if (!request) {
+                PACKIO_INFO("stop reading: {}", request.error());
+                break;
+            }
+
+            // requests of a batch are returned consecutively,
+            // the first one carries the size of the batch
+            if (request->batch_size > 0) {
+                batch_ = std::make_shared<response_batch>(request->batch_size);
+                batch_remaining_ = request->batch_size;
+            }
+            std::shared_ptr<response_batch> request_batch;
+            if (batch_remaining_ > 0) {
+                --batch_remaining_;
+                request_batch = batch_;
+            }
+            if (tracked()) {
+                pending_requests_.fetch_add(1);
+            }
+            on_request_read();
+
+            if (!request->invalid.empty()) {
+                PACKIO_DEBUG("invalid request: {}", request->invalid);
+                async_send_invalid_request_response(
+                    request->id, std::move(request_batch));
+                continue;
+            }
+
+            auto function = request->method_id
+                                ? dispatcher_ptr_->find_id(*request->method_id)
+                                : dispatcher_ptr_->find(request->method);
+            internal::call_metrics metrics;
+#if PACKIO_HAS_METRICS
+            if (function && function->metrics()) {
+                metrics = internal::call_metrics{function->metrics()};
+            }
+#endif // PACKIO_HAS_METRICS
+            if (is_rate_limited(function)) {
+                async_handle_request(
+                    std::move(*request),
+                    std::move(request_batch),
+                    {},
+                    {},
+                    kRateLimitedError);
+                continue;
+            }
+            if (function && function->is_inline()) {
+                async_handle_request(
+                    std::move(*request),
+                    std::move(request_batch),
+                    std::move(function),
+                    std::move(metrics));
+                continue;
+            }
+
+            // handle the call asynchronously (post)
+            // to schedule the next read immediately
+            // this will allow parallel call handling
+            // in multi-threaded environments
+            std::optional<internal::any_io_executor> executor;
+            auto priority = priority_class::normal;
+            if (function) {
+                executor = function->executor();
+                priority = function->priority();
+            }
+            // the queueing delay is checked when the request is executed,
+            // only the queue of the session executor is measured
+            bool measured = codel_ && !executor;
+            auto received = measured ? clock_type::now() : clock_type::time_point{};
+            auto handle = [self = shared_from_this(),
+                           request = std::move(*request),
+                           batch = std::move(request_batch),
+                           function = std::move(function),
+                           metrics = std::move(metrics),
+                           measured,
+                           received]() mutable {
+                self->async_handle_request(
+                    std::move(request),
+                    std::move(batch),
+                    std::move(function),
+                    std::move(metrics),
+                    measured && self->should_shed(received) ? kOverloadedError
+                                                            : nullptr);
+            };
+            if (executor) {
+                // the procedure runs on its own executor
+                net::post(*executor, std::move(handle));
+            }
+            else if (scheduler_) {
+                scheduler_->post(
+                    get_executor(),
+                    static_cast<std::size_t>(priority),
+                    std::move(handle));
+            }
+            else {
+                net::post(get_executor(), std::move(handle));
+            }
+        }
+
+        batch_.reset();
+        async_read();
+    }
+
+    bool limited() const noexcept
+    {
+        return max_pending_requests_ > 0 || max_queued_response_bytes_ > 0;
+    }
+
+    bool has_timeouts() const noexcept
+    {
+        return idle_timeout_ != clock_type::duration::zero()
+               || read_timeout_ != clock_type::duration::zero();
+    }
+
+    //! Check if pending requests and queued responses are counted
+    bool tracked() const noexcept
+    {
+        return limited() || idle_timeout_ != clock_type::duration::zero();
+    }
+
+    bool should_shed(clock_type::time_point received)
+    {
+        if (!codel_) {
+            return false;
+        }
+        auto now = clock_type::now();
+        if (!codel_->should_shed(now - received, now)) {
+            return false;
+        }
+        if (counters_) {
+            ++counters_->shed;
+        }
+        return true;
+    }
+
+    bool is_rate_limited(const procedure_ref& function)
+    {
+        bool session_limited = rate_limit_.enabled();
+        bool procedure_limited = function && function->rate_limit().enabled();
+        if (!session_limited && !procedure_limited) {
+            return false;
+        }
+        // a request is only charged to the session when its procedure
+        // accepts it
+        auto now = clock_type::now();
+        bool limited = procedure_limited && !function->rate_limit().try_acquire(now);
+        if (!limited && session_limited && !rate_limit_.try_acquire(now)) {
+            if (procedure_limited) {
+                function->rate_limit().release();
+            }
+            limited = true;
+        }
+        if (limited && counters_) {
+            ++counters_->rate_limited;
+        }
+        return limited;
+    }
+
+    void on_bytes_read(std::size_t length)
+    {
+#if PACKIO_HAS_METRICS
+        metrics_.bytes_in.fetch_add(length, std::memory_order_relaxed);
+        if (counters_) {
+            counters_->metrics.local().bytes_in.fetch_add(
+                length, std::memory_order_relaxed);
+        }
+#else // PACKIO_HAS_METRICS
+        (void)length;
+#endif // PACKIO_HAS_METRICS
+    }
+
+    void on_request_read()
+    {
+#if PACKIO_HAS_METRICS
+        metrics_.messages_in.fetch_add(1, std::memory_order_relaxed);
+        if (counters_) {
+            counters_->metrics.local().messages_in.fetch_add(
+                1, std::memory_order_relaxed);
+        }
+#endif // PACKIO_HAS_METRICS
+    }
+
+    void on_response_written(std::size_t length)
+    {
+#if PACKIO_HAS_METRICS
+        metrics_.bytes_out.fetch_add(length, std::memory_order_relaxed);
+        metrics_.messages_out.fetch_add(1, std::memory_order_relaxed);
+        if (counters_) {
+            auto& metrics = counters_->metrics.local();
+            metrics.bytes_out.fetch_add(length, std::memory_order_relaxed);
+            metrics.messages_out.fetch_add(1, std::memory_order_relaxed);
+        }
+#else // PACKIO_HAS_METRICS
+        (void)length;
+#endif // PACKIO_HAS_METRICS
+    }
+
+    void on_activity()
+    {
+        auto now = clock_type::now();
+        last_read_ = now;
+        last_activity_.store(
+            now.time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    void check_timeouts()
+    {
+        assert(strand_.running_in_this_thread());
+        if (!socket_.is_open()) {
+            return;
+        }
+
+        auto now = clock_type::now();
+        auto next = clock_type::time_point::max();
+        if (idle_timeout_ != clock_type::duration::zero()) {
+            auto last_activity = clock_type::time_point{clock_type::duration{
+                last_activity_.load(std::memory_order_relaxed)}};
+            bool idle = pending_requests_.load() == 0
+                        && queued_response_bytes_.load() == 0;
+            if (idle && last_activity + idle_timeout_ <= now) {
+                on_timeout("idle");
+                return;
+            }
+            next = std::min(
+                next, idle ? last_activity + idle_timeout_ : now + idle_timeout_);
+        }
+        if (read_timeout_ != clock_type::duration::zero()) {
+            bool partial = parser_.unparsed_size() > 0 && !reading_paused_.load();
+            if (partial && last_read_ + read_timeout_ <= now) {
+                on_timeout("read");
+                return;
+            }
+            next = std::min(
+                next, partial ? last_read_ + read_timeout_ : now + read_timeout_);
+        }
+
+        // the timer does not keep the session alive
+        timeout_timer_.expires_at(next);
+        timeout_timer_.async_wait(internal::bind_executor(
+            strand_, [weak_self = weak_from_this()](error_code ec) {
+                auto self = weak_self.lock();
+                if (ec || !self) {
+                    return;
+                }
+                self->check_timeouts();
+            }));
+    }
+
+    void on_timeout(const char* reason)
     {
+        PACKIO_INFO("{} timeout, closing the session", reason);
+        (void)reason;
+        if (counters_) {
+            ++counters_->timed_out;
+        }
+        close_connection();
+    }
+
+    bool over_limits() const noexcept
+    {
+        return (max_pending_requests_ > 0
+                && pending_requests_.load() >= max_pending_requests_)
+               || (max_queued_response_bytes_ > 0
+                   && queued_response_bytes_.load() >= max_queued_response_bytes_);
+    }
+
+    bool should_pause_reading()
+    {
+        assert(strand_.running_in_this_thread());
+        if (!limited() || !over_limits()) {
+            return false;
+        }
+        // publish the pause before checking the limits again, so that
+        // a request completing concurrently either sees the pause and
+        // resumes reading, or is seen here
+        reading_paused_.store(true);
+        if (over_limits()) {
+            return true;
+        }
+        reading_paused_.store(false);
+        return false;
+    }
+
+    void maybe_resume_reading()
+    {
+        if (!reading_paused_.load()) {
+            return;
+        }
+        net::dispatch(strand_, [self = shared_from_this()] {
+            if (self->reading_paused_.load() && !self->over_limits()) {
+                PACKIO_DEBUG("resume reading");
+                self->reading_paused_.store(false);
+                self->handle_requests();
+            }
+        });
+    }
+
+    void request_done()
+    {
+        if (tracked()) {
+            last_activity_.store(
+                clock_type::now().time_since_epoch().count(),
+                std::memory_order_relaxed);
+            pending_requests_.fetch_sub(1);
+            maybe_resume_reading();
+        }
+    }
+
+    void async_handle_request(
+        request_type&& request,
+        std::shared_ptr<response_batch> batch,
+        procedure_ref function,
+        internal::call_metrics metrics,
+        const char* rejection = nullptr)
+    {
+        metrics.start();
         completion_handler<Rpc> handler(
             request.id,
-            [type = request.type, id = request.id, self = shared_from_this()](
-                auto&& response_buffer) {
-                if (type == call_type::request) {
+            [type = request.type,
+             id = request.id,
+             self = shared_from_this(),
+             batch = std::move(batch),
+             metrics = std::move(metrics)](
+                response_buffer_type&& response_buffer, bool error) mutable {
+                metrics.complete(error);
+                if (batch) {
+                    self->async_send_batch_response(
+                        *batch,
+                        type,
+                        std::move(response_buffer),
+                        std::move(metrics));
+                }
+                else if (type == call_type::request) {
                     PACKIO_TRACE("result (id={})", Rpc::format_id(id));
                     (void)id;
-                    self->async_send_response(std::move(response_buffer));
+                    self->async_send_response(
+                        std::move(response_buffer), std::move(metrics));
                 }
+                self->request_done();
             });
 
-        const auto function = dispatcher_ptr_->get(request.method);
-        if (function) {
+        if (rejection) {
+            PACKIO_DEBUG("{}: {}", rejection, request.method);
+            handler.set_error(rejection);
+        }
+        else if (function) {
             PACKIO_TRACE(
                 "call: {} (id={})", request.method, Rpc::format_id(request.id));
+            if (auto memo = function->memo()) {
+                async_call_idempotent(
+                    std::move(memo),
+                    std::move(function),
+                    std::move(handler),
+                    std::move(request.args));
+                return;
+            }
             (*function)(std::move(handler), std::move(request.args));
         }
         else {
@@ -150,8 +733,91 @@ private:
         }
     }
 
-    template <typename Buffer>
-    void async_send_response(Buffer&& response_buffer)
+    void async_send_invalid_request_response(
+        const typename Rpc::id_type& id,
+        std::shared_ptr<response_batch> batch)
+    {
+        auto response_buffer = Rpc::serialize_invalid_request_response(id);
+        if (batch) {
+            async_send_batch_response(
+                *batch, call_type::request, std::move(response_buffer), {});
+        }
+        else {
+            async_send_response(std::move(response_buffer));
+        }
+        request_done();
+    }
+
+    //! Call an idempotent procedure, unless an identical call is in
+    //! progress or its result is cached
+    void async_call_idempotent(
+        std::shared_ptr<internal::memo_cache> memo,
+        procedure_ref function,
+        completion_handler<Rpc> handler,
+        typename Rpc::native_type&& args)
+    {
+        auto key = Rpc::serialize_args(args);
+        auto lookup = memo->lookup(key, [&] {
+            auto waiter = [handler = std::move(handler)](
+                              internal::memo_cache::result_type result,
+                              bool error) mutable {
+                if (error) {
+                    handler.set_serialized_error(*result);
+                }
+                else {
+                    handler.set_serialized_value(*result);
+                }
+            };
+            static_assert(
+                internal::memo_cache::waiter_type::is_stored_inline_v<decltype(waiter)>,
+                "waiters must be stored inline");
+            return internal::memo_cache::waiter_type{std::move(waiter)};
+        });
+
+        if (lookup.cached) {
+            handler.set_serialized_value(*lookup.cached);
+            return;
+        }
+        if (!lookup.leader) {
+            return;
+        }
+        handler.share_result(
+            [memo = std::move(memo), key = std::move(key)](
+                internal::memo_cache::result_type result, bool error) {
+                memo->complete(key, std::move(result), error);
+            });
+        (*function)(std::move(handler), std::move(args));
+    }
+
+    void async_send_batch_response(
+        response_batch& batch,
+        call_type type,
+        response_buffer_type&& response_buffer,
+        internal::call_metrics metrics)
+    {
+        std::unique_lock lock{batch.mutex};
+        if (type == call_type::request) {
+            batch.responses.push_back(std::move(response_buffer));
+            batch.metrics.add(std::move(metrics));
+        }
+        if (--batch.remaining > 0) {
+            return;
+        }
+        // a batch of notifications has no response
+        if (batch.responses.empty()) {
+            return;
+        }
+        auto responses = std::move(batch.responses);
+        auto batch_metrics = std::move(batch.metrics);
+        lock.unlock();
+
+        PACKIO_TRACE("batch result ({} responses)", responses.size());
+        async_send_response(
+            Rpc::serialize_batch(std::move(responses)), std::move(batch_metrics));
+    }
+
+    template <typename Buffer, typename Metrics = internal::call_metrics>
+    void async_send_response(Buffer&& response_buffer, Metrics metrics = {})
     {
         // abort R/W on error
         if (!socket_.is_open()) {
@@ -159,31 +825,30 @@ private:
         }
 
         auto message_ptr = internal::to_unique_ptr(std::move(response_buffer));
+        auto buf = Rpc::buffer(*message_ptr);
+        if (tracked()) {
+            queued_response_bytes_.fetch_add(buf.size());
+        }
+        wstrand_.push(
+            buf,
+            [self = shared_from_this(),
+             message_ptr = std::move(message_ptr),
+             size = buf.size(),
+             metrics = std::move(metrics)](error_code ec, size_t length) mutable {
+                if (self->tracked()) {
+                    self->queued_response_bytes_.fetch_sub(size);
+                    self->maybe_resume_reading();
+                }
+                if (ec) {
+                    PACKIO_WARN("write error: {}", ec.message());
+                    self->close_connection();
+                    return;
+                }
 
-        wstrand_.push([this,
-                       self = shared_from_this(),
-                       message_ptr = std::move(message_ptr)]() mutable {
-            assert(strand_.running_in_this_thread());
-            auto buf = Rpc::buffer(*message_ptr);
-            net::async_write(
-                socket_,
-                buf,
-                internal::bind_executor(
-                    strand_,
-                    [self = std::move(self), message_ptr = std::move(message_ptr)](
-                        error_code ec, size_t length) {
-                        self->wstrand_.next();
-
-                        if (ec) {
-                            PACKIO_WARN("write error: {}", ec.message());
-                            self->close_connection();
-                            return;
-                        }
-
-                        PACKIO_TRACE("write: {}", length);
-                        (void)length;
-                    }));
-        });
+                PACKIO_TRACE("write: {}", length);
+                self->on_response_written(length);
+                metrics.written();
+            });
     }
 
     void close_connection()
@@ -196,11 +861,36 @@ private:
     }
 
     socket_type socket_;
-    std::size_t buffer_reserve_size_{kDefaultBufferReserveSize};
+    internal::buffer_reserve buffer_reserve_{
+        kDefaultBufferReserveSize,
+        kDefaultMaxBufferReserveSize};
+    parser_type parser_;
+    bool release_buffer_{false};
+    std::shared_ptr<response_batch> batch_;
+    std::size_t batch_remaining_{0};
+
+    std::size_t max_pending_requests_{0};
+    std::size_t max_queued_response_bytes_{0};
+    std::atomic<std::size_t> pending_requests_{0};
+    std::atomic<std::size_t> queued_response_bytes_{0};
+    std::atomic<bool> reading_paused_{false};
     std::shared_ptr<Dispatcher> dispatcher_ptr_;
+    std::shared_ptr<internal::session_counters> counters_;
+    std::shared_ptr<internal::codel> codel_;
+    std::shared_ptr<internal::priority_scheduler> scheduler_;
+    internal::token_bucket rate_limit_;
+#if PACKIO_HAS_METRICS
+    internal::session_metrics metrics_;
+#endif // PACKIO_HAS_METRICS
+
+    clock_type::duration idle_timeout_{clock_type::duration::zero()};
+    clock_type::duration read_timeout_{clock_type::duration::zero()};
+    clock_type::time_point last_read_;
+    std::atomic<clock_type::rep> last_activity_{0};
 
     net::strand<executor_type> strand_;
-    internal::manual_strand<executor_type> wstrand_;
+    internal::manual_strand<socket_type> wstrand_;
+    net::steady_timer timeout_timer_;
 };
 
 } // packio
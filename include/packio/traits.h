@@ -10,6 +10,7 @@
 
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "internal/config.h"
 #include "internal/rpc.h"
@@ -72,6 +73,14 @@ template <typename T>
 struct NotifyHandler : Trait<std::is_invocable_v<T, error_code>> {
 };
 
+//! ConnectHandler trait
+//!
+//! Handler used by @ref client_pool::async_connect
+//! - Must be callable with an error_code
+template <typename T>
+struct ConnectHandler : Trait<std::is_invocable_v<T, error_code>> {
+};
+
 //! CallHandler trait
 //!
 //! Handler used by @ref client::async_call
@@ -81,6 +90,34 @@ struct CallHandler
     : Trait<std::is_invocable_v<T, error_code, typename Rpc::response_type>> {
 };
 
+//! TypedCallHandler trait
+//!
+//! Handler used by @ref client::async_call_as
+//! - Must be callable with error_code, client::call_result<R>
+template <typename T, typename Result>
+struct TypedCallHandler : Trait<std::is_invocable_v<T, error_code, Result>> {
+};
+
+//! MethodIdsHandler trait
+//!
+//! Handler used by @ref client::async_get_method_ids
+//! - Must be callable with error_code, client::call_result<client::method_ids_type>
+template <typename T, typename Result>
+struct MethodIdsHandler : Trait<std::is_invocable_v<T, error_code, Result>> {
+};
+
+//! CallBatchHandler trait
+//!
+//! Handler used by @ref client::async_call_batch
+//! - Must be callable with error_code, std::vector<response_type>
+template <typename T, typename Rpc>
+struct CallBatchHandler
+    : Trait<std::is_invocable_v<
+          T,
+          error_code,
+          std::vector<typename Rpc::response_type>>> {
+};
+
 //! ServeHandler trait
 //!
 //! Handler used by @ref server::async_serve
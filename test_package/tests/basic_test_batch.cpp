@@ -0,0 +1,127 @@
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_call_batch)
+{
+    using response_type = typename TestFixture::client_type::response_type;
+
+    this->server_->async_serve_forever();
+    this->server_->dispatcher()->add("echo", [](int i) { return i; });
+    this->server_->dispatcher()->add("add", [](int a, int b) { return a + b; });
+    this->async_run();
+    this->connect();
+
+    {
+        std::vector<std::pair<std::string, std::tuple<int>>> calls;
+        for (int i = 0; i < 10; ++i) {
+            calls.emplace_back("echo", std::tuple{i});
+        }
+        auto future = this->client_->async_call_batch(calls, use_future);
+        ASSERT_FUTURE_NO_BLOCK(future, 1s);
+        auto responses = future.get();
+        ASSERT_EQ(calls.size(), responses.size());
+        for (int i = 0; i < 10; ++i) {
+            EXPECT_FALSE(is_error_response(responses[i]));
+            EXPECT_EQ(i, get<int>(responses[i].result));
+        }
+    }
+
+    {
+        std::vector<std::tuple<std::string_view, std::tuple<int, int>>> calls{
+            {"add", {1, 2}},
+            {"unknown", {3, 4}},
+            {"add", {5, 6}},
+        };
+        std::promise<std::vector<response_type>> promise;
+        auto future = promise.get_future();
+        this->client_->async_call_batch(
+            calls,
+            [&](error_code ec, std::vector<response_type> responses) {
+                EXPECT_FALSE(ec);
+                promise.set_value(std::move(responses));
+            });
+        ASSERT_FUTURE_NO_BLOCK(future, 1s);
+        auto responses = future.get();
+        ASSERT_EQ(3u, responses.size());
+        EXPECT_EQ(3, get<int>(responses[0].result));
+        EXPECT_TRUE(is_error_response(responses[1]));
+        EXPECT_EQ("unknown function", get_error_message(responses[1].error));
+        EXPECT_EQ(11, get<int>(responses[2].result));
+    }
+
+    {
+        std::vector<std::pair<std::string, std::tuple<>>> calls;
+        auto future = this->client_->async_call_batch(calls, use_future);
+        ASSERT_FUTURE_NO_BLOCK(future, 1s);
+        EXPECT_TRUE(future.get().empty());
+    }
+
+    // regular calls still work after a batch
+    auto future = this->client_->async_call("echo", std::tuple{42}, use_future);
+    EXPECT_RESULT_EQ(future, 42);
+}
+
+#if PACKIO_HAS_NLOHMANN_JSON
+TEST(BatchTest, test_invalid_batch_members)
+{
+    io_context io;
+    auto server = nl_json_rpc::make_server(
+        ip::tcp::acceptor{io, get_endpoint<ip::tcp::endpoint>()});
+    server->dispatcher()->add("echo", [](int i) { return i; });
+    server->async_serve_forever();
+    std::thread thread{[&] { io.run(); }};
+
+    ip::tcp::socket socket{io};
+    socket.connect(server->acceptor().local_endpoint());
+    auto call = [&](const std::string& request) {
+        write(socket, buffer(request));
+        std::string data;
+        while (!nlohmann::json::accept(data)) {
+            char chunk[256];
+            data.append(chunk, socket.read_some(buffer(chunk)));
+        }
+        return nlohmann::json::parse(data);
+    };
+    auto is_invalid_request = [](const nlohmann::json& response) {
+        return response.at("id").is_null()
+               && response.at("error").at("code") == -32600;
+    };
+
+    // each invalid member gets its own error, valid members are still called
+    auto responses = call(
+        R"([1,{"jsonrpc":"2.0","method":"echo","params":[3],"id":1},{"jsonrpc":"2.0"}])");
+    ASSERT_TRUE(responses.is_array());
+    ASSERT_EQ(3u, responses.size());
+    int invalid = 0;
+    for (const auto& response : responses) {
+        if (response.contains("result")) {
+            EXPECT_EQ(1, response.at("id"));
+            EXPECT_EQ(3, response.at("result"));
+        }
+        else {
+            EXPECT_TRUE(is_invalid_request(response));
+            ++invalid;
+        }
+    }
+    EXPECT_EQ(2, invalid);
+
+    // invalid members are answered with their id when it can be read
+    responses = call(R"([{"jsonrpc":"2.0","method":5.5,"id":3}])");
+    ASSERT_TRUE(responses.is_array());
+    ASSERT_EQ(1u, responses.size());
+    EXPECT_EQ(3, responses[0].at("id"));
+    EXPECT_EQ(-32600, responses[0].at("error").at("code"));
+
+    // an empty batch gets a single error
+    auto response = call("[]");
+    ASSERT_TRUE(response.is_object());
+    EXPECT_TRUE(is_invalid_request(response));
+
+    socket.close();
+    io.stop();
+    thread.join();
+}
+#endif // PACKIO_HAS_NLOHMANN_JSON
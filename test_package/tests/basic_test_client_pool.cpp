@@ -0,0 +1,98 @@
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_client_pool)
+{
+    using client_type = typename std::decay_t<decltype(*this)>::client_type;
+    using socket_type = typename std::decay_t<decltype(*this)>::socket_type;
+    using pool_type = client_pool<
+        typename client_type::rpc_type,
+        socket_type,
+        packio::default_map>;
+    constexpr int kNClients{4};
+    constexpr int kNCalls{100};
+
+    this->server_->async_serve_forever();
+    this->server_->dispatcher()->add("echo", [](int i) { return i; });
+    this->async_run();
+
+    std::vector<std::shared_ptr<typename pool_type::client_type>> clients;
+    for (int i = 0; i < kNClients; ++i) {
+        clients.push_back(std::make_shared<typename pool_type::client_type>(
+            socket_type{this->io_}));
+        clients.back()->socket().connect(
+            this->server_->acceptor().local_endpoint());
+    }
+    pool_type pool{clients};
+    ASSERT_EQ(static_cast<std::size_t>(kNClients), pool.size());
+
+    for (auto policy :
+         {balancing_policy::power_of_two_choices,
+          balancing_policy::least_pending}) {
+        pool.set_balancing_policy(policy);
+        ASSERT_EQ(policy, pool.get_balancing_policy());
+
+        std::vector<std::future<typename pool_type::response_type>> futures;
+        for (int i = 0; i < kNCalls; ++i) {
+            futures.push_back(pool.async_call("echo", std::tuple{i}, use_future));
+        }
+        for (int i = 0; i < kNCalls; ++i) {
+            EXPECT_RESULT_EQ(futures[i], i);
+        }
+        EXPECT_EQ(0u, pool.pending_calls());
+    }
+
+    const auto echo = TestFixture::client_type::prepare("echo");
+    auto prepared = pool.async_call(echo, std::tuple{24}, use_future);
+    EXPECT_RESULT_EQ(prepared, 24);
+
+    auto f = pool.async_notify("echo", std::tuple{42}, use_future);
+    EXPECT_FUTURE_NO_THROW(f);
+}
+
+TEST(ClientPoolTest, test_async_connect)
+{
+    using pool_type = default_rpc::client_pool<ip::tcp::socket>;
+
+    io_context io;
+    auto server = default_rpc::make_server(
+        ip::tcp::acceptor{io, get_endpoint<ip::tcp::endpoint>()});
+    server->dispatcher()->add("echo", [](int i) { return i; });
+    server->async_serve_forever();
+
+    auto pool = default_rpc::make_client_pool<ip::tcp::socket>(io, 3);
+    ASSERT_EQ(3u, pool->size());
+
+    std::vector<ip::tcp::endpoint> endpoints{server->acceptor().local_endpoint()};
+    std::optional<error_code> connect_ec;
+    // the completion runs on the executor associated with the handler
+    auto strand = make_strand(io);
+    bool on_strand = false;
+    pool->async_connect(endpoints, bind_executor(strand, [&](error_code ec) {
+                            on_strand = strand.running_in_this_thread();
+                            connect_ec = ec;
+                        }));
+    io.run_for(1s);
+    ASSERT_TRUE(connect_ec);
+    ASSERT_TRUE(on_strand);
+    ASSERT_FALSE(*connect_ec);
+    for (const auto& client : pool->clients()) {
+        ASSERT_TRUE(client->socket().is_open());
+    }
+
+    io.restart();
+    std::optional<int> result;
+    pool->async_call(
+        "echo",
+        std::tuple{42},
+        [&](error_code ec, typename pool_type::response_type res) {
+            ASSERT_FALSE(ec);
+            result = get<int>(res.result);
+        });
+    io.run_for(1s);
+    ASSERT_TRUE(result);
+    ASSERT_EQ(42, *result);
+}
@@ -0,0 +1,45 @@
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_frozen_dispatcher)
+{
+    constexpr int kNCalls{100};
+    using response_type = typename TestFixture::client_type::response_type;
+
+    auto dispatcher = this->server_->dispatcher();
+    dispatcher->add("double", [](int i) { return 2 * i; });
+    dispatcher->add_inline("triple", [](int i) { return 3 * i; });
+    ASSERT_FALSE(dispatcher->is_frozen());
+    dispatcher->freeze();
+    ASSERT_TRUE(dispatcher->is_frozen());
+
+    // procedures can no longer be added or removed
+    ASSERT_FALSE(dispatcher->add("other", [] {}));
+    ASSERT_FALSE(dispatcher->remove("double"));
+    ASSERT_EQ(0u, dispatcher->clear());
+    ASSERT_TRUE(dispatcher->has("double"));
+    ASSERT_FALSE(dispatcher->has("other"));
+
+    ASSERT_TRUE(dispatcher->find(std::string_view{"double"}));
+    ASSERT_TRUE(dispatcher->find("triple")->is_inline());
+    ASSERT_FALSE(dispatcher->find("other"));
+
+    this->server_->async_serve_forever();
+    this->async_run();
+    this->connect();
+
+    std::vector<std::future<response_type>> futures;
+    for (int i = 0; i < kNCalls; ++i) {
+        futures.push_back(this->client_->async_call(
+            i % 2 ? "double" : "triple", std::tuple{i}, use_future));
+    }
+    for (int i = 0; i < kNCalls; ++i) {
+        EXPECT_RESULT_EQ(futures[i], (i % 2 ? 2 : 3) * i);
+    }
+    EXPECT_ERROR_EQ(
+        this->client_->async_call("other", std::tuple{}, use_future),
+        "unknown function");
+}
@@ -0,0 +1,151 @@
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_idempotent)
+{
+    using completion_handler =
+        typename std::decay_t<decltype(*this)>::completion_handler;
+    using response_type = typename TestFixture::client_type::response_type;
+
+    std::mutex mutex;
+    std::vector<std::pair<completion_handler, int>> pending;
+    std::atomic<int> n_calls{0};
+    auto dispatcher = this->server_->dispatcher();
+    dispatcher->add_async("square", [&](completion_handler handler, int x) {
+        ++n_calls;
+        std::unique_lock lock{mutex};
+        pending.emplace_back(std::move(handler), x);
+    });
+    ASSERT_TRUE(dispatcher->set_idempotent("square", 1min));
+    ASSERT_FALSE(dispatcher->set_idempotent("square"));
+    ASSERT_FALSE(dispatcher->set_idempotent("unknown"));
+    ASSERT_EQ(1min, dispatcher->find("square")->memo()->ttl());
+
+    this->server_->async_serve_forever();
+    this->async_run();
+    this->connect();
+
+    std::vector<std::future<response_type>> futures;
+    for (int i = 0; i < 4; ++i) {
+        futures.push_back(
+            this->client_->async_call("square", std::tuple{3}, use_future));
+    }
+    futures.push_back(
+        this->client_->async_call("square", std::tuple{4}, use_future));
+
+    // a single execution per distinct argument
+    auto deadline = std::chrono::steady_clock::now() + 1s;
+    while (n_calls < 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    ASSERT_EQ(2, n_calls.load());
+    {
+        std::unique_lock lock{mutex};
+        for (auto& [handler, x] : pending) {
+            handler(x * x);
+        }
+        pending.clear();
+    }
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_RESULT_EQ(futures[i], 9);
+    }
+    EXPECT_RESULT_EQ(futures[4], 16);
+
+    // the results are cached
+    auto cached = this->client_->async_call("square", std::tuple{3}, use_future);
+    EXPECT_RESULT_EQ(cached, 9);
+    ASSERT_EQ(2, n_calls.load());
+}
+
+TYPED_TEST(BasicTest, test_idempotent_error)
+{
+    using completion_handler =
+        typename std::decay_t<decltype(*this)>::completion_handler;
+
+    std::atomic<int> n_calls{0};
+    auto dispatcher = this->server_->dispatcher();
+    dispatcher->add_async("flaky", [&](completion_handler handler) {
+        if (++n_calls == 1) {
+            handler.set_error("flaky error");
+        }
+        else {
+            handler(42);
+        }
+    });
+    ASSERT_TRUE(dispatcher->set_idempotent("flaky", 1min));
+
+    this->server_->async_serve_forever();
+    this->async_run();
+    this->connect();
+
+    // errors are not cached
+    auto failed = this->client_->async_call("flaky", std::tuple{}, use_future);
+    EXPECT_ERROR_EQ(failed, "flaky error");
+    auto succeeded = this->client_->async_call("flaky", std::tuple{}, use_future);
+    EXPECT_RESULT_EQ(succeeded, 42);
+    auto cached = this->client_->async_call("flaky", std::tuple{}, use_future);
+    EXPECT_RESULT_EQ(cached, 42);
+    ASSERT_EQ(2, n_calls.load());
+}
+
+TYPED_TEST(BasicTest, test_idempotent_shared_error)
+{
+    using completion_handler =
+        typename std::decay_t<decltype(*this)>::completion_handler;
+    using response_type = typename TestFixture::client_type::response_type;
+
+    std::mutex mutex;
+    std::vector<completion_handler> pending;
+    std::atomic<int> n_calls{0};
+    auto dispatcher = this->server_->dispatcher();
+    dispatcher->add_async("fetch", [&](completion_handler handler) {
+        ++n_calls;
+        std::unique_lock lock{mutex};
+        pending.push_back(std::move(handler));
+    });
+    ASSERT_TRUE(dispatcher->set_idempotent("fetch", 1min));
+    auto memo = dispatcher->find("fetch")->memo();
+
+    this->server_->async_serve_forever();
+    this->async_run();
+    this->connect();
+
+    auto wait_for = [](auto&& predicate) {
+        for (int i = 0; i < 100 && !predicate(); ++i) {
+            std::this_thread::sleep_for(10ms);
+        }
+        return predicate();
+    };
+
+    std::vector<std::future<response_type>> futures;
+    for (int i = 0; i < 4; ++i) {
+        futures.push_back(
+            this->client_->async_call("fetch", std::tuple{}, use_future));
+    }
+    ASSERT_TRUE(wait_for([&] { return memo->waiting() == 3; }));
+
+    // the error of the call is shared with the calls waiting for it
+    {
+        std::unique_lock lock{mutex};
+        ASSERT_EQ(1u, pending.size());
+        pending.front().set_error("backend down");
+        pending.clear();
+    }
+    for (auto& future : futures) {
+        EXPECT_ERROR_EQ(future, "backend down");
+    }
+    ASSERT_EQ(1, n_calls.load());
+
+    // and is not cached
+    auto retried = this->client_->async_call("fetch", std::tuple{}, use_future);
+    ASSERT_TRUE(wait_for([&] { return n_calls == 2; }));
+    {
+        std::unique_lock lock{mutex};
+        pending.front()(42);
+        pending.clear();
+    }
+    EXPECT_RESULT_EQ(retried, 42);
+}
@@ -0,0 +1,123 @@
+#include <list>
+#include <thread>
+
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_in_flight_limit)
+{
+    using completion_handler = typename TestFixture::completion_handler;
+    using socket_type = typename TestFixture::socket_type;
+    using response_type = typename TestFixture::client_type::response_type;
+
+    std::mutex mtx;
+    std::list<std::pair<completion_handler, int>> pending;
+    const auto received = [&](std::size_t count) {
+        for (int i = 0; i < 100; ++i) {
+            {
+                std::unique_lock l{mtx};
+                if (pending.size() >= count) {
+                    break;
+                }
+            }
+            std::this_thread::sleep_for(10ms);
+        }
+        std::unique_lock l{mtx};
+        return pending.size();
+    };
+    const auto complete = [&] {
+        std::unique_lock l{mtx};
+        for (auto& [handler, i] : pending) {
+            handler(i);
+        }
+        pending.clear();
+    };
+
+    this->server_->async_serve_forever();
+    this->server_->dispatcher()->add("echo", [](int i) { return i; });
+    this->server_->dispatcher()->add_async(
+        "block", [&](completion_handler handler, int i) {
+            std::unique_lock l{mtx};
+            pending.emplace_back(std::move(handler), i);
+        });
+    this->async_run();
+    this->connect();
+
+    ASSERT_EQ(0u, this->client_->get_max_in_flight());
+    this->client_->set_max_in_flight(2);
+    ASSERT_EQ(2u, this->client_->get_max_in_flight());
+    ASSERT_EQ(2u, this->client_->get_in_flight_limit());
+
+    // calls beyond the limit are queued until a call completes
+    std::vector<std::future<response_type>> futures;
+    for (int i = 0; i < 4; ++i) {
+        futures.push_back(
+            this->client_->async_call("block", std::tuple{i}, use_future));
+    }
+    ASSERT_EQ(4u, this->client_->pending_calls());
+    ASSERT_EQ(2u, received(2));
+    std::this_thread::sleep_for(20ms);
+    ASSERT_EQ(2u, received(3));
+    complete();
+    EXPECT_RESULT_EQ(futures[0], 0);
+    EXPECT_RESULT_EQ(futures[1], 1);
+    ASSERT_EQ(2u, received(2));
+    complete();
+    EXPECT_RESULT_EQ(futures[2], 2);
+    EXPECT_RESULT_EQ(futures[3], 3);
+    ASSERT_EQ(0u, this->client_->pending_calls());
+
+    if constexpr (supports_cancellation<socket_type>()) {
+        // queued calls are cancelled with the calls in flight
+        this->client_->set_max_in_flight(1);
+        auto sent = this->client_->async_call("block", std::tuple{0}, use_future);
+        auto queued = this->client_->async_call("block", std::tuple{1}, use_future);
+        ASSERT_EQ(1u, received(1));
+        this->client_->cancel();
+        EXPECT_FUTURE_CANCELLED(sent);
+        EXPECT_FUTURE_CANCELLED(queued);
+        ASSERT_EQ(0u, this->client_->pending_calls());
+        std::unique_lock l{mtx};
+        pending.clear();
+    }
+
+    this->client_->set_max_in_flight(16);
+    this->client_->set_adaptive_in_flight(true);
+    ASSERT_TRUE(this->client_->get_adaptive_in_flight());
+    futures.clear();
+    for (int i = 0; i < 64; ++i) {
+        futures.push_back(
+            this->client_->async_call("echo", std::tuple{i}, use_future));
+    }
+    for (int i = 0; i < 64; ++i) {
+        EXPECT_RESULT_EQ(futures[i], i);
+    }
+    ASSERT_GE(this->client_->get_in_flight_limit(), 1u);
+    ASSERT_LE(this->client_->get_in_flight_limit(), 16u);
+}
+
+TEST(TestConcurrencyLimit, test_adaptive_limit)
+{
+    using clock_type = internal::concurrency_limit::clock_type;
+    internal::concurrency_limit limit;
+
+    // adaptive without a maximum is still disabled
+    limit.set_adaptive(true);
+    EXPECT_FALSE(limit.enabled());
+    EXPECT_EQ(0u, limit.limit());
+
+    limit.set_max(10);
+    EXPECT_EQ(10u, limit.limit());
+
+    // a slow call shrinks the limit
+    auto now = clock_type::now();
+    limit.on_complete(1ms, false, 9, now);
+    limit.on_complete(10ms, false, 9, now + 1s);
+    EXPECT_EQ(9u, limit.limit());
+
+    limit.set_adaptive(false);
+    EXPECT_EQ(10u, limit.limit());
+}
@@ -0,0 +1,41 @@
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_inline_completion)
+{
+    using response_type = typename TestFixture::client_type::response_type;
+
+    this->server_->async_serve_forever();
+    this->server_->dispatcher()->add("echo", [](int i) { return i; });
+    this->async_run();
+    this->connect();
+
+    ASSERT_FALSE(this->client_->get_inline_completion());
+    this->client_->set_inline_completion(true);
+    ASSERT_TRUE(this->client_->get_inline_completion());
+
+    for (int i = 0; i < 5; ++i) {
+        auto future = this->client_->async_call("echo", std::tuple{i}, use_future);
+        EXPECT_RESULT_EQ(future, i);
+    }
+
+    // the associated executor of the handler is honored in both modes
+    for (bool inline_completion : {true, false}) {
+        this->client_->set_inline_completion(inline_completion);
+
+        auto strand = make_strand(this->io_);
+        std::promise<bool> promise;
+        auto future = promise.get_future();
+        this->client_->async_call(
+            "echo",
+            std::tuple{42},
+            bind_executor(strand, [&](error_code ec, response_type) {
+                promise.set_value(!ec && strand.running_in_this_thread());
+            }));
+        ASSERT_FUTURE_NO_BLOCK(future, 1s);
+        EXPECT_TRUE(future.get());
+    }
+}
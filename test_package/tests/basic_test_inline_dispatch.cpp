@@ -0,0 +1,38 @@
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_inline_dispatch)
+{
+    constexpr int kNCalls{200};
+    using response_type = typename TestFixture::client_type::response_type;
+
+    std::atomic<int> inline_calls{0};
+    this->server_->async_serve_forever();
+    ASSERT_TRUE(this->server_->dispatcher()->add_inline("inline", [&](int i) {
+        ++inline_calls;
+        return i;
+    }));
+    ASSERT_FALSE(this->server_->dispatcher()->add_inline(
+        "inline", [](int i) { return i; }));
+    this->server_->dispatcher()->add("posted", [](int i) { return i; });
+    this->async_run();
+    this->connect();
+
+    // inline and posted procedures can be pipelined together
+    std::vector<std::future<response_type>> futures;
+    for (int i = 0; i < kNCalls; ++i) {
+        futures.push_back(this->client_->async_call(
+            i % 3 ? "inline" : "posted", std::tuple{i}, use_future));
+    }
+    for (int i = 0; i < kNCalls; ++i) {
+        EXPECT_RESULT_EQ(futures[i], i);
+    }
+    ASSERT_EQ(kNCalls - (kNCalls + 2) / 3, inline_calls.load());
+
+    EXPECT_ERROR_EQ(
+        this->client_->async_call("inline", std::tuple{1, 2}, use_future),
+        "cannot convert arguments: too many arguments");
+}
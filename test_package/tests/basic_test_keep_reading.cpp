@@ -0,0 +1,104 @@
+#include <list>
+#include <thread>
+
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_keep_reading)
+{
+    using completion_handler = typename TestFixture::completion_handler;
+    using socket_type = typename TestFixture::socket_type;
+
+    std::mutex mtx;
+    std::list<completion_handler> pending;
+
+    this->server_->async_serve_forever();
+    this->server_->dispatcher()->add("echo", [](int i) { return i; });
+    this->server_->dispatcher()->add_async(
+        "block", [&](completion_handler handler) {
+            std::unique_lock l{mtx};
+            pending.push_back(std::move(handler));
+        });
+    this->async_run();
+    this->connect();
+
+    ASSERT_FALSE(this->client_->get_keep_reading());
+    this->client_->set_keep_reading(true);
+    ASSERT_TRUE(this->client_->get_keep_reading());
+
+    for (int i = 0; i < 5; ++i) {
+        auto future = this->client_->async_call("echo", std::tuple{i}, use_future);
+        // no call pending after this, the read operation continues
+        EXPECT_RESULT_EQ(future, i);
+    }
+
+    if constexpr (supports_cancellation<socket_type>()) {
+        // cancelling the last pending call does not stop reading
+        auto blocked = this->client_->async_call("block", use_future);
+        ASSERT_FUTURE_BLOCKS(blocked, 10ms);
+        this->client_->cancel();
+        EXPECT_FUTURE_CANCELLED(blocked);
+
+        auto future = this->client_->async_call("echo", std::tuple{42}, use_future);
+        EXPECT_RESULT_EQ(future, 42);
+    }
+
+    std::unique_lock l{mtx};
+    pending.clear();
+}
+
+#if PACKIO_HAS_NLOHMANN_JSON
+TEST(KeepReadingTest, test_reconnect_drops_partial_response)
+{
+    io_context io;
+    auto server = nl_json_rpc::make_server(
+        ip::tcp::acceptor{io, get_endpoint<ip::tcp::endpoint>()});
+    server->dispatcher()->add("echo", [](int i) { return i; });
+    server->async_serve_forever();
+
+    // answers the first request with a truncated response
+    ip::tcp::acceptor truncating{io, get_endpoint<ip::tcp::endpoint>()};
+    ip::tcp::socket truncated{io};
+    std::string partial = R"({"jsonrpc":"2.0","id":0,"res)";
+    char request[256];
+    truncating.async_accept(truncated, [&](error_code ec) {
+        ASSERT_FALSE(ec);
+        truncated.async_read_some(buffer(request), [&](error_code ec, size_t) {
+            ASSERT_FALSE(ec);
+            async_write(truncated, buffer(partial), [](error_code, size_t) {});
+        });
+    });
+
+    auto work = make_work_guard(io);
+    std::thread thread{[&] { io.run(); }};
+
+    auto client = nl_json_rpc::make_client(ip::tcp::socket{io});
+    client->set_keep_reading(true);
+    client->socket().connect(truncating.local_endpoint());
+    auto blocked = client->async_call("echo", std::tuple{1}, use_future);
+    std::this_thread::sleep_for(50ms);
+    client->cancel();
+    EXPECT_FUTURE_CANCELLED(blocked);
+
+    // closing the socket aborts the read and drops the partial response
+    std::promise<void> closed;
+    post(io, [&] {
+        client->socket().close();
+        closed.set_value();
+    });
+    closed.get_future().wait();
+    std::this_thread::sleep_for(10ms);
+    client->socket().connect(server->acceptor().local_endpoint());
+
+    auto future = client->async_call("echo", std::tuple{42}, use_future);
+    EXPECT_RESULT_EQ(future, 42);
+
+    client->socket().close();
+    work.reset();
+    io.stop();
+    thread.join();
+}
+#endif // PACKIO_HAS_NLOHMANN_JSON
@@ -0,0 +1,99 @@
+#include <thread>
+
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_load_shedding)
+{
+    constexpr int kNCalls{50};
+    using response_type = typename TestFixture::client_type::response_type;
+    using session_type = typename TestFixture::server_type::session_type;
+
+    ASSERT_EQ(0ms, this->server_->get_load_shedding_target());
+    this->server_->set_load_shedding(1ms, 5ms);
+    ASSERT_EQ(1ms, this->server_->get_load_shedding_target());
+    ASSERT_EQ(5ms, this->server_->get_load_shedding_interval());
+
+    this->server_->dispatcher()->add("slow", [](int i) {
+        std::this_thread::sleep_for(2ms);
+        return i;
+    });
+    this->server_->dispatcher()->add_inline("inline", [](int i) { return i; });
+    this->server_->async_serve_forever();
+    this->async_run();
+    this->connect();
+
+    // the requests queue behind the slow procedure
+    std::vector<std::future<response_type>> futures;
+    for (int i = 0; i < kNCalls; ++i) {
+        futures.push_back(
+            this->client_->async_call("slow", std::tuple{i}, use_future));
+    }
+    auto inline_future =
+        this->client_->async_call("inline", std::tuple{42}, use_future);
+
+    int n_shed = 0;
+    for (int i = 0; i < kNCalls; ++i) {
+        ASSERT_FUTURE_NO_BLOCK(futures[i], 1s);
+        auto response = futures[i].get();
+        if (is_error_response(response)) {
+            ASSERT_EQ(
+                session_type::kOverloadedError,
+                get_error_message(response.error));
+            ++n_shed;
+        }
+        else {
+            ASSERT_EQ(i, get<int>(response.result));
+        }
+    }
+    ASSERT_GT(n_shed, 0);
+    ASSERT_LT(n_shed, kNCalls);
+    ASSERT_EQ(std::uint64_t(n_shed), this->server_->get_shed_requests());
+    EXPECT_RESULT_EQ(inline_future, 42);
+
+    // once the queue is drained, requests are served again
+    EXPECT_RESULT_EQ(
+        this->client_->async_call("slow", std::tuple{1}, use_future), 1);
+}
+
+TYPED_TEST(BasicTest, test_load_shedding_procedure_executor)
+{
+    constexpr int kNCalls{20};
+    using response_type = typename TestFixture::client_type::response_type;
+
+    this->server_->set_load_shedding(1ms, 5ms);
+
+    // the queue of the thread pool is not the queue of the sessions
+    thread_pool pool{1};
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    this->server_->dispatcher()->add("blocked", pool, [released](int i) {
+        released.wait();
+        return i;
+    });
+    this->server_->dispatcher()->add("fast", [](int i) { return i; });
+    this->server_->async_serve_forever();
+    this->async_run();
+    this->connect();
+
+    std::vector<std::future<response_type>> blocked;
+    for (int i = 0; i < kNCalls; ++i) {
+        blocked.push_back(
+            this->client_->async_call("blocked", std::tuple{i}, use_future));
+    }
+    std::this_thread::sleep_for(20ms);
+    for (int i = 0; i < kNCalls; ++i) {
+        EXPECT_RESULT_EQ(
+            this->client_->async_call("fast", std::tuple{i}, use_future), i);
+    }
+
+    release.set_value();
+    for (int i = 0; i < kNCalls; ++i) {
+        EXPECT_RESULT_EQ(blocked[i], i);
+    }
+    ASSERT_EQ(0u, this->server_->get_shed_requests());
+    pool.join();
+}
@@ -0,0 +1,101 @@
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_method_ids)
+{
+    using client_type = typename TestFixture::client_type;
+    using dispatcher_type = typename TestFixture::server_type::dispatcher_type;
+
+    auto dispatcher = this->server_->dispatcher();
+    dispatcher->add("add", [](int a, int b) { return a + b; });
+    dispatcher->add_async(
+        "answer", [](completion_handler<typename client_type::rpc_type> handler) {
+            handler(42);
+        });
+    this->server_->async_serve_forever();
+    this->async_run();
+    this->connect();
+
+    // no ID before the dispatcher is frozen
+    EXPECT_ERROR_EQ(
+        this->client_->async_call(client_type::prepare("add", 0), use_future),
+        "unknown function");
+    {
+        auto future = this->client_->async_get_method_ids(use_future);
+        ASSERT_FUTURE_NO_BLOCK(future, 1s);
+        auto calls = future.get();
+        ASSERT_FALSE(calls);
+        EXPECT_EQ("unknown function", calls.error().message);
+    }
+
+    ASSERT_TRUE(dispatcher->freeze());
+    ASSERT_TRUE(dispatcher->has(std::string{dispatcher_type::kMethodIdsProcedure}));
+
+    // the listing maps names to IDs, the high bits of the IDs are shared
+    auto future = this->client_->async_call(
+        dispatcher_type::kMethodIdsProcedure, use_future);
+    ASSERT_FUTURE_NO_BLOCK(future, 1s);
+    auto response = future.get();
+    ASSERT_FALSE(is_error_response(response));
+    auto ids = get<std::map<std::string, std::uint64_t>>(response.result);
+    ASSERT_EQ(3u, ids.size());
+    auto hash = ids.at("add") >> 32;
+    for (const auto& [name, id] : ids) {
+        EXPECT_EQ(hash, id >> 32) << name;
+    }
+
+    // the client learns the IDs by name, then uses them
+    auto calls_future = this->client_->async_get_method_ids(use_future);
+    ASSERT_FUTURE_NO_BLOCK(calls_future, 1s);
+    auto calls = calls_future.get();
+    ASSERT_TRUE(calls);
+    ASSERT_EQ(3u, calls->size());
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_RESULT_EQ(
+            this->client_->async_call(
+                calls->at("add"), std::tuple{i, 2 * i}, use_future),
+            3 * i);
+    }
+    EXPECT_RESULT_EQ(
+        this->client_->async_call(calls->at("answer"), use_future), 42);
+    EXPECT_RESULT_EQ(
+        this->client_->async_call(
+            calls->find(dispatcher_type::kMethodIdsProcedure)->second,
+            use_future),
+        ids);
+
+    // names keep working, unknown IDs and IDs of other sets are rejected
+    EXPECT_RESULT_EQ(
+        this->client_->async_call("add", std::tuple{1, 2}, use_future), 3);
+    EXPECT_ERROR_EQ(
+        this->client_->async_call(
+            client_type::prepare("unknown", (hash << 32) | ids.size()),
+            use_future),
+        "unknown function");
+    EXPECT_ERROR_EQ(
+        this->client_->async_call(
+            client_type::prepare("add", ids.at("add") ^ (std::uint64_t{1} << 32)),
+            std::tuple{1, 2},
+            use_future),
+        "unknown function");
+}
+
+TYPED_TEST(BasicTest, test_method_ids_reserved_name)
+{
+    using dispatcher_type = typename TestFixture::server_type::dispatcher_type;
+
+    auto dispatcher = this->server_->dispatcher();
+    ASSERT_TRUE(dispatcher->add(
+        std::string{dispatcher_type::kMethodIdsProcedure}, [] { return 0; }));
+
+    // the reserved name is taken, the dispatcher cannot assign IDs
+    ASSERT_FALSE(dispatcher->freeze());
+    ASSERT_FALSE(dispatcher->is_frozen());
+
+    ASSERT_TRUE(dispatcher->remove(std::string{dispatcher_type::kMethodIdsProcedure}));
+    ASSERT_TRUE(dispatcher->freeze());
+    ASSERT_TRUE(dispatcher->is_frozen());
+}
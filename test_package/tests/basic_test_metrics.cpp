@@ -0,0 +1,129 @@
+#include <thread>
+
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+#if PACKIO_HAS_METRICS
+
+TYPED_TEST(BasicTest, test_metrics)
+{
+    constexpr int kNCalls{30};
+    using response_type = typename TestFixture::client_type::response_type;
+    using completion_handler = typename TestFixture::completion_handler;
+
+    auto dispatcher = this->server_->dispatcher();
+    ASSERT_FALSE(dispatcher->get_metrics_enabled());
+    dispatcher->add("unmeasured", [](int i) { return i; });
+    dispatcher->set_metrics_enabled(true);
+    ASSERT_TRUE(dispatcher->get_metrics_enabled());
+    dispatcher->add("sync", [](int i) {
+        std::this_thread::sleep_for(1ms);
+        return i;
+    });
+    dispatcher->add_inline("inline", [](int i) { return i; });
+    dispatcher->add_async("async", [](completion_handler handler, int i) {
+        if (i % 8 == 2) {
+            handler.set_error("error");
+        }
+        else {
+            handler(i);
+        }
+    });
+
+    this->server_->async_serve_forever();
+    this->async_run();
+    this->connect();
+
+    std::vector<std::future<response_type>> futures;
+    for (int i = 0; i < kNCalls; ++i) {
+        const char* names[] = {"sync", "inline", "async", "unmeasured"};
+        futures.push_back(
+            this->client_->async_call(names[i % 4], std::tuple{i}, use_future));
+    }
+    for (auto& future : futures) {
+        ASSERT_FUTURE_NO_BLOCK(future, 1s);
+        future.get();
+    }
+
+    // responses are received before their write completion is measured
+    auto wait_for = [](auto&& predicate) {
+        for (int i = 0; i < 100 && !predicate(); ++i) {
+            std::this_thread::sleep_for(10ms);
+        }
+        return predicate();
+    };
+    ASSERT_TRUE(wait_for([&] {
+        auto metrics = dispatcher->metrics();
+        std::uint64_t written = 0;
+        for (const auto& procedure : metrics) {
+            written += procedure.write_time.count;
+        }
+        return written == 23u; // 8 sync, 8 inline, 7 async
+    }));
+
+    auto metrics = dispatcher->metrics();
+    ASSERT_EQ(3u, metrics.size());
+    ASSERT_EQ("async", metrics[0].name);
+    ASSERT_EQ(7u, metrics[0].calls);
+    ASSERT_EQ(4u, metrics[0].errors);
+    ASSERT_EQ("inline", metrics[1].name);
+    ASSERT_EQ(8u, metrics[1].calls);
+    ASSERT_EQ(0u, metrics[1].errors);
+    ASSERT_EQ("sync", metrics[2].name);
+    ASSERT_EQ(8u, metrics[2].calls);
+    ASSERT_EQ(8u, metrics[2].queue_time.count);
+    ASSERT_EQ(8u, metrics[2].execution_time.count);
+    ASSERT_GE(metrics[2].execution_time.value_at_quantile(0.5), 1000000u);
+
+    ASSERT_TRUE(wait_for([&] {
+        return this->server_->get_session_metrics().messages_out == kNCalls;
+    }));
+    auto sessions = this->server_->get_session_metrics();
+    ASSERT_EQ(std::uint64_t{kNCalls}, sessions.messages_in);
+    ASSERT_GT(sessions.bytes_in, 0u);
+    ASSERT_GT(sessions.bytes_out, 0u);
+
+    std::string out;
+    write_prometheus(out, metrics);
+    write_prometheus(out, sessions);
+    ASSERT_NE(
+        std::string::npos,
+        out.find("packio_procedure_calls_total{procedure=\"sync\"} 8\n"));
+    ASSERT_NE(
+        std::string::npos,
+        out.find("packio_session_messages_in_total " + std::to_string(kNCalls)));
+}
+
+TYPED_TEST(BasicTest, test_metrics_batch)
+{
+    auto dispatcher = this->server_->dispatcher();
+    dispatcher->set_metrics_enabled(true);
+    dispatcher->add("echo", [](int i) { return i; });
+
+    this->server_->async_serve_forever();
+    this->async_run();
+    this->connect();
+
+    std::vector<std::pair<std::string, std::tuple<int>>> calls;
+    for (int i = 0; i < 5; ++i) {
+        calls.emplace_back("echo", std::tuple{i});
+    }
+    auto future = this->client_->async_call_batch(calls, use_future);
+    ASSERT_FUTURE_NO_BLOCK(future, 1s);
+    future.get();
+
+    // each call of the batch is measured when the batch is written
+    for (int i = 0; i < 100 && dispatcher->metrics()[0].write_time.count < 5;
+         ++i) {
+        std::this_thread::sleep_for(10ms);
+    }
+    auto metrics = dispatcher->metrics();
+    ASSERT_EQ(1u, metrics.size());
+    ASSERT_EQ(5u, metrics[0].calls);
+    ASSERT_EQ(5u, metrics[0].write_time.count);
+}
+
+#endif // PACKIO_HAS_METRICS
@@ -0,0 +1,32 @@
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_pipelining)
+{
+    constexpr int kNCalls{200};
+
+    this->server_->async_serve_forever();
+    this->server_->dispatcher()->add("echo", [](int i) { return i; });
+    this->async_run();
+    this->connect();
+
+    for (std::size_t max_buffers : {1, 3, 64}) {
+        this->client_->set_max_write_buffers(max_buffers);
+        this->client_->set_max_write_size(max_buffers * 32);
+        ASSERT_EQ(max_buffers, this->client_->get_max_write_buffers());
+        ASSERT_EQ(max_buffers * 32, this->client_->get_max_write_size());
+
+        std::vector<std::future<typename TestFixture::client_type::response_type>>
+            futures;
+        for (int i = 0; i < kNCalls; ++i) {
+            futures.push_back(this->client_->async_call(
+                "echo", std::tuple{i}, use_future));
+        }
+        for (int i = 0; i < kNCalls; ++i) {
+            EXPECT_RESULT_EQ(futures[i], i);
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_prepared_call)
+{
+    using client_type = typename TestFixture::client_type;
+
+    this->server_->async_serve_forever();
+    this->server_->dispatcher()->add("add", [](int a, int b) { return a + b; });
+    this->server_->dispatcher()->add("answer", []() { return 42; });
+    this->async_run();
+    this->connect();
+
+    const auto add = client_type::prepare("add");
+    const auto answer = client_type::prepare("answer");
+    const auto unknown = client_type::prepare("unk\"nown");
+
+    for (int i = 0; i < 10; ++i) {
+        auto future = this->client_->async_call(add, std::tuple{i, 2 * i}, use_future);
+        EXPECT_RESULT_EQ(future, 3 * i);
+    }
+
+    {
+        auto future = this->client_->async_call(answer, use_future);
+        EXPECT_RESULT_EQ(future, 42);
+    }
+
+    {
+        auto future = this->client_->async_call(unknown, use_future);
+        EXPECT_ERROR_EQ(future, "unknown function");
+    }
+
+    {
+        auto future = this->client_->template async_call_as<int>(
+            add, std::tuple{12, 23}, use_future);
+        ASSERT_FUTURE_NO_BLOCK(future, 1s);
+        auto result = future.get();
+        ASSERT_TRUE(result);
+        EXPECT_EQ(35, *result);
+    }
+}
@@ -0,0 +1,51 @@
+#include <algorithm>
+#include <thread>
+
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_priorities)
+{
+    constexpr int kNBulk{10};
+    using response_type = typename TestFixture::client_type::response_type;
+
+    ASSERT_FALSE(this->server_->get_priority_scheduling());
+    this->server_->set_priority_scheduling(true);
+    ASSERT_TRUE(this->server_->get_priority_scheduling());
+
+    // only accessed by the thread running the io_context
+    std::vector<std::string> order;
+    auto dispatcher = this->server_->dispatcher();
+    dispatcher->add("bulk", [&] {
+        order.push_back("bulk");
+        std::this_thread::sleep_for(10ms);
+    });
+    dispatcher->add("health", [&] { order.push_back("health"); });
+    ASSERT_TRUE(dispatcher->set_priority("bulk", priority_class::low));
+    ASSERT_TRUE(dispatcher->set_priority("health", priority_class::high));
+    ASSERT_FALSE(dispatcher->set_priority("unknown", priority_class::high));
+    ASSERT_EQ(priority_class::low, dispatcher->find("bulk")->priority());
+
+    this->server_->async_serve_forever();
+    this->async_run();
+    this->connect();
+
+    std::vector<std::future<response_type>> futures;
+    for (int i = 0; i < kNBulk; ++i) {
+        futures.push_back(
+            this->client_->async_call("bulk", std::tuple{}, use_future));
+    }
+    futures.push_back(
+        this->client_->async_call("health", std::tuple{}, use_future));
+    for (auto& future : futures) {
+        EXPECT_RESULT_IS_OK(future);
+    }
+
+    // the health check overtakes the queued bulk requests
+    ASSERT_EQ(std::size_t{kNBulk + 1}, order.size());
+    auto health = std::find(order.begin(), order.end(), "health");
+    ASSERT_LT(health - order.begin(), kNBulk / 2);
+}
@@ -0,0 +1,51 @@
+#include <thread>
+
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_procedure_executor)
+{
+    using completion_handler = typename TestFixture::completion_handler;
+
+    thread_pool pool{1};
+    std::promise<std::thread::id> pool_thread;
+    post(pool, [&] { pool_thread.set_value(std::this_thread::get_id()); });
+    const auto pool_id = pool_thread.get_future().get();
+
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    this->server_->async_serve_forever();
+    this->server_->dispatcher()->add(
+        "on_pool", pool, [&] { return std::this_thread::get_id() == pool_id; });
+    this->server_->dispatcher()->add(
+        "blocking", pool.get_executor(), {"i"}, [&](int i) {
+            released.wait();
+            return i;
+        });
+    this->server_->dispatcher()->add_async(
+        "async_on_pool", pool, [&](completion_handler handler) {
+            handler(std::this_thread::get_id() == pool_id);
+        });
+    this->server_->dispatcher()->add(
+        "on_io", [&] { return std::this_thread::get_id() != pool_id; });
+    this->async_run();
+    this->connect();
+
+    EXPECT_RESULT_EQ(this->client_->async_call("on_pool", use_future), true);
+    EXPECT_RESULT_EQ(
+        this->client_->async_call("async_on_pool", use_future), true);
+    EXPECT_RESULT_EQ(this->client_->async_call("on_io", use_future), true);
+
+    // a blocked pool does not stall the procedures of the io_context
+    auto blocked = this->client_->async_call(
+        "blocking", std::tuple{42}, use_future);
+    EXPECT_RESULT_EQ(this->client_->async_call("on_io", use_future), true);
+    EXPECT_EQ(std::future_status::timeout, blocked.wait_for(10ms));
+    release.set_value();
+    EXPECT_RESULT_EQ(blocked, 42);
+
+    pool.join();
+}
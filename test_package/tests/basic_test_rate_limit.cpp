@@ -0,0 +1,93 @@
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_rate_limit)
+{
+    using response_type = typename TestFixture::client_type::response_type;
+    using session_type = typename TestFixture::server_type::session_type;
+
+    // refilled too slowly to matter during the test
+    auto dispatcher = this->server_->dispatcher();
+    std::atomic<int> n_expensive{0};
+    dispatcher->add("expensive", [&] { ++n_expensive; });
+    dispatcher->add("cheap", [] {});
+    ASSERT_TRUE(dispatcher->set_rate_limit("expensive", 0.01, 2));
+    ASSERT_FALSE(dispatcher->set_rate_limit("unknown", 1.));
+    ASSERT_EQ(0.01, dispatcher->find("expensive")->rate_limit().rate());
+    this->server_->set_session_rate_limit(0.01, 5);
+    ASSERT_EQ(0.01, this->server_->get_session_rate_limit());
+    ASSERT_EQ(5u, this->server_->get_session_rate_limit_burst());
+
+    this->server_->async_serve_forever();
+    this->async_run();
+    this->connect();
+
+    std::vector<std::future<response_type>> futures;
+    for (int i = 0; i < 3; ++i) {
+        futures.push_back(
+            this->client_->async_call("expensive", std::tuple{}, use_future));
+    }
+    for (int i = 0; i < 4; ++i) {
+        futures.push_back(
+            this->client_->async_call("cheap", std::tuple{}, use_future));
+    }
+
+    // the procedure bucket serves 2 expensive calls, only these take
+    // tokens of the session bucket, leaving 3 for the cheap calls
+    const char* expected[] = {
+        nullptr,
+        nullptr,
+        session_type::kRateLimitedError,
+        nullptr,
+        nullptr,
+        nullptr,
+        session_type::kRateLimitedError,
+    };
+    for (std::size_t i = 0; i < futures.size(); ++i) {
+        if (expected[i]) {
+            EXPECT_ERROR_EQ(futures[i], expected[i]);
+        }
+        else {
+            EXPECT_RESULT_IS_OK(futures[i]);
+        }
+    }
+    ASSERT_EQ(2, n_expensive.load());
+    ASSERT_EQ(2u, this->server_->get_rate_limited_requests());
+}
+
+TYPED_TEST(BasicTest, test_rate_limit_procedure_rejections)
+{
+    using response_type = typename TestFixture::client_type::response_type;
+    using session_type = typename TestFixture::server_type::session_type;
+
+    auto dispatcher = this->server_->dispatcher();
+    dispatcher->add("throttled", [] {});
+    dispatcher->add("free", [] {});
+    ASSERT_TRUE(dispatcher->set_rate_limit("throttled", 0.01, 1));
+    this->server_->set_session_rate_limit(0.01, 3);
+
+    this->server_->async_serve_forever();
+    this->async_run();
+    this->connect();
+
+    // the calls rejected by the procedure limit keep the session budget
+    std::vector<std::future<response_type>> throttled;
+    for (int i = 0; i < 5; ++i) {
+        throttled.push_back(
+            this->client_->async_call("throttled", std::tuple{}, use_future));
+    }
+    EXPECT_RESULT_IS_OK(throttled[0]);
+    for (int i = 1; i < 5; ++i) {
+        EXPECT_ERROR_EQ(throttled[i], session_type::kRateLimitedError);
+    }
+    for (int i = 0; i < 2; ++i) {
+        auto free = this->client_->async_call("free", std::tuple{}, use_future);
+        EXPECT_RESULT_IS_OK(free);
+    }
+    auto exhausted = this->client_->async_call("free", std::tuple{}, use_future);
+    EXPECT_ERROR_EQ(exhausted, session_type::kRateLimitedError);
+    ASSERT_EQ(5u, this->server_->get_rate_limited_requests());
+}
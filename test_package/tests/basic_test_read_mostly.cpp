@@ -0,0 +1,56 @@
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_read_mostly)
+{
+    constexpr int kNCalls{100};
+    using response_type = typename TestFixture::client_type::response_type;
+
+    auto dispatcher = this->server_->dispatcher();
+    ASSERT_FALSE(dispatcher->get_read_mostly());
+    dispatcher->add("before", [](int i) { return i; });
+    dispatcher->set_read_mostly(true);
+    ASSERT_TRUE(dispatcher->get_read_mostly());
+    ASSERT_TRUE(dispatcher->find("before"));
+    ASSERT_FALSE(dispatcher->find("after"));
+
+    // procedures can still be added and removed
+    ASSERT_TRUE(dispatcher->add("after", [](int i) { return 2 * i; }));
+    ASSERT_TRUE(dispatcher->add_inline("inline", [](int i) { return 3 * i; }));
+    ASSERT_TRUE(dispatcher->find("after"));
+
+    this->server_->async_serve_forever();
+    this->async_run();
+    this->connect();
+
+    std::vector<std::future<response_type>> futures;
+    for (int i = 0; i < kNCalls; ++i) {
+        const char* names[] = {"before", "after", "inline"};
+        futures.push_back(
+            this->client_->async_call(names[i % 3], std::tuple{i}, use_future));
+    }
+    for (int i = 0; i < kNCalls; ++i) {
+        EXPECT_RESULT_EQ(futures[i], (i % 3 + 1) * i);
+    }
+
+    ASSERT_TRUE(dispatcher->remove("before"));
+    ASSERT_FALSE(dispatcher->find("before"));
+    EXPECT_ERROR_EQ(
+        this->client_->async_call("before", std::tuple{1}, use_future),
+        "unknown function");
+
+    // a procedure found before its removal stays valid
+    auto procedure = dispatcher->find("after");
+    ASSERT_TRUE(procedure);
+    ASSERT_EQ(2u, dispatcher->clear());
+    ASSERT_TRUE(procedure);
+    ASSERT_FALSE(procedure->is_inline());
+
+    dispatcher->set_read_mostly(false);
+    ASSERT_TRUE(dispatcher->add("after", [](int i) { return 4 * i; }));
+    EXPECT_RESULT_EQ(
+        this->client_->async_call("after", std::tuple{2}, use_future), 8);
+}
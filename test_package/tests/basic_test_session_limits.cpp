@@ -0,0 +1,70 @@
+#include <list>
+#include <thread>
+
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_session_limits)
+{
+    using completion_handler = typename TestFixture::completion_handler;
+    using response_type = typename TestFixture::client_type::response_type;
+
+    std::mutex mtx;
+    std::list<std::pair<completion_handler, int>> pending;
+    const auto received = [&](std::size_t count) {
+        for (int i = 0; i < 100; ++i) {
+            {
+                std::unique_lock l{mtx};
+                if (pending.size() >= count) {
+                    break;
+                }
+            }
+            std::this_thread::sleep_for(10ms);
+        }
+        std::unique_lock l{mtx};
+        return pending.size();
+    };
+    const auto complete = [&] {
+        std::unique_lock l{mtx};
+        for (auto& [handler, i] : pending) {
+            handler(i);
+        }
+        pending.clear();
+    };
+
+    this->server_->dispatcher()->add_async(
+        "block", [&](completion_handler handler, int i) {
+            std::unique_lock l{mtx};
+            pending.emplace_back(std::move(handler), i);
+        });
+    ASSERT_EQ(0u, this->server_->get_session_max_pending_requests());
+    ASSERT_EQ(0u, this->server_->get_session_max_queued_response_bytes());
+    this->server_->set_session_max_pending_requests(2);
+    this->server_->set_session_max_queued_response_bytes(1 << 20);
+    this->server_->async_serve([&](auto ec, auto session) {
+        ASSERT_FALSE(ec);
+        ASSERT_EQ(2u, session->get_max_pending_requests());
+        ASSERT_EQ(1u << 20, session->get_max_queued_response_bytes());
+        session->start();
+    });
+    this->async_run();
+    this->connect();
+
+    // the session stops reading while two requests are pending
+    std::vector<std::future<response_type>> futures;
+    for (int i = 0; i < 6; ++i) {
+        futures.push_back(
+            this->client_->async_call("block", std::tuple{i}, use_future));
+    }
+    for (int i = 0; i < 6; i += 2) {
+        ASSERT_EQ(2u, received(2));
+        std::this_thread::sleep_for(20ms);
+        ASSERT_EQ(2u, received(3));
+        complete();
+        EXPECT_RESULT_EQ(futures[i], i);
+        EXPECT_RESULT_EQ(futures[i + 1], i + 1);
+    }
+}
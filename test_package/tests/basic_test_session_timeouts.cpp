@@ -0,0 +1,127 @@
+#include <thread>
+
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+namespace {
+
+template <typename Predicate>
+bool wait_for(Predicate&& predicate, std::chrono::milliseconds timeout = 2s)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(5ms);
+    }
+    return true;
+}
+
+} // namespace
+
+TYPED_TEST(BasicTest, test_session_idle_timeout)
+{
+    this->server_->set_session_idle_timeout(100ms);
+    this->server_->dispatcher()->add("sleep", [](int ms) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{ms});
+        return ms;
+    });
+    this->server_->async_serve_forever();
+    this->async_run();
+    this->connect();
+
+    // a pending request keeps the session alive
+    EXPECT_RESULT_EQ(
+        this->client_->async_call("sleep", std::tuple{150}, use_future), 150);
+    for (int i = 0; i < 4; ++i) {
+        std::this_thread::sleep_for(50ms);
+        EXPECT_RESULT_EQ(
+            this->client_->async_call("sleep", std::tuple{0}, use_future), 0);
+    }
+    ASSERT_EQ(1u, this->server_->get_accepted_sessions());
+    ASSERT_EQ(0u, this->server_->get_timed_out_sessions());
+
+    ASSERT_TRUE(wait_for([&] {
+        return this->server_->get_timed_out_sessions() == 1
+               && this->server_->get_active_sessions() == 0;
+    }));
+}
+
+TYPED_TEST(BasicTest, test_session_read_timeout)
+{
+    using rpc_type = typename TestFixture::client_type::rpc_type;
+
+    this->server_->set_session_read_timeout(100ms);
+    this->server_->async_serve_forever();
+    this->server_->dispatcher()->add("echo", [](int i) { return i; });
+    this->async_run();
+    this->connect();
+
+    // waiting for a request is not a read timeout
+    std::this_thread::sleep_for(200ms);
+    EXPECT_RESULT_EQ(this->client_->async_call("echo", std::tuple{1}, use_future), 1);
+    ASSERT_EQ(1u, this->server_->get_active_sessions());
+
+    // the beginning of a request that is never completed
+    std::string partial = std::is_same_v<rpc_type, packio::nl_json_rpc::rpc>
+                              ? "{\"jsonrpc\""
+                              : "\x94";
+    auto written = async_write(
+        this->client_->socket(), buffer(partial), use_future);
+    ASSERT_FUTURE_NO_BLOCK(written, 1s);
+    written.get();
+
+    ASSERT_TRUE(wait_for([&] {
+        return this->server_->get_timed_out_sessions() == 1
+               && this->server_->get_active_sessions() == 0;
+    }));
+}
+
+TYPED_TEST(BasicTest, test_max_sessions)
+{
+    using client_type = typename TestFixture::client_type;
+    using socket_type = typename TestFixture::socket_type;
+    using endpoint_type = typename TestFixture::endpoint_type;
+
+    this->server_->set_max_sessions(1);
+    this->server_->async_serve_forever();
+    this->server_->dispatcher()->add("echo", [](int i) { return i; });
+    this->async_run();
+    this->connect();
+    EXPECT_RESULT_EQ(this->client_->async_call("echo", std::tuple{1}, use_future), 1);
+    ASSERT_EQ(1u, this->server_->get_active_sessions());
+
+    // the second connection is closed by the server
+    auto ep = this->server_->acceptor().local_endpoint();
+    {
+        auto other = std::make_shared<client_type>(
+            socket_type{this->io_, endpoint_type().protocol()});
+        try {
+            other->socket().connect(ep);
+            auto future = other->async_call("echo", std::tuple{2}, use_future);
+            ASSERT_FUTURE_NO_BLOCK(future, 1s);
+            EXPECT_THROW(future.get(), system_error);
+        }
+        catch (const system_error&) {
+            // the handshake of encrypted streams fails
+        }
+    }
+    ASSERT_TRUE(wait_for([&] { return this->server_->get_rejected_sessions() == 1; }));
+    ASSERT_EQ(1u, this->server_->get_accepted_sessions());
+
+    // the first session is not affected
+    EXPECT_RESULT_EQ(this->client_->async_call("echo", std::tuple{3}, use_future), 3);
+
+    // a connection is accepted again once a session ends
+    this->client_->socket().close();
+    ASSERT_TRUE(wait_for([&] { return this->server_->get_active_sessions() == 0; }));
+    auto other = std::make_shared<client_type>(
+        socket_type{this->io_, endpoint_type().protocol()});
+    other->socket().connect(ep);
+    EXPECT_RESULT_EQ(other->async_call("echo", std::tuple{4}, use_future), 4);
+    ASSERT_EQ(2u, this->server_->get_accepted_sessions());
+}
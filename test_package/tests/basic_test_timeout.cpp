@@ -1,3 +1,5 @@
+#include <list>
+
 #include "basic_test.h"
 
 using namespace std::chrono_literals;
@@ -83,3 +85,87 @@ TYPED_TEST(BasicTest, test_timeout)
         this->io_.stop();
     }
 }
+
+TYPED_TEST(BasicTest, test_call_timeout)
+{
+    using client_type = typename std::decay_t<decltype(*this)>::client_type;
+    using socket_type = typename std::decay_t<decltype(*this)>::socket_type;
+    using completion_handler =
+        typename std::decay_t<decltype(*this)>::completion_handler;
+
+    this->server_->async_serve_forever();
+    this->async_run();
+    this->connect();
+
+    std::mutex mtx;
+    std::list<completion_handler> pending;
+    this->server_->dispatcher()->add_async(
+        "block", [&](completion_handler handler) {
+            std::unique_lock l{mtx};
+            pending.push_back(std::move(handler));
+        });
+    this->server_->dispatcher()->add("echo", [](int i) { return i; });
+
+    // warm up the connection, the first call may be slow
+    auto warmup = this->client_->async_call("echo", std::tuple{0}, use_future);
+    EXPECT_RESULT_EQ(warmup, 0);
+
+    ASSERT_EQ(
+        std::chrono::steady_clock::duration::zero(),
+        this->client_->get_call_timeout());
+    this->client_->set_call_timeout(100ms);
+    ASSERT_EQ(100ms, this->client_->get_call_timeout());
+
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto f1 = this->client_->async_call("block", use_future);
+        auto f2 = this->client_->async_call("block", use_future);
+        auto f3 = this->client_->async_call("echo", std::tuple{42}, use_future);
+        EXPECT_RESULT_EQ(f3, 42);
+
+        for (auto* f : {&f1, &f2}) {
+            try {
+                ASSERT_FUTURE_NO_BLOCK((*f), 1s);
+                EXPECT_GE(std::chrono::steady_clock::now() - start, 100ms);
+                f->get();
+                EXPECT_FALSE(true) << "future did not time out";
+            }
+            catch (system_error& err) {
+                EXPECT_EQ(net::error::timed_out, err.code());
+            }
+        }
+    }
+
+    {
+        // late responses of timed out calls are ignored
+        std::unique_lock l{mtx};
+        for (auto& pending_handler : pending) {
+            pending_handler();
+        }
+        pending.clear();
+    }
+
+    this->client_->set_call_timeout(1s);
+    auto f = this->client_->async_call("echo", std::tuple{12}, use_future);
+    EXPECT_RESULT_EQ(f, 12);
+
+    if constexpr (supports_cancellation<socket_type>()) {
+        // client runs out of work once all its calls timed out
+        io_context io;
+        auto client = std::make_shared<client_type>(socket_type{io});
+        client->socket().connect(this->server_->acceptor().local_endpoint());
+        client->set_call_timeout(50ms);
+
+        bool timed_out{false};
+        client->async_call("block", [&](auto ec, auto) {
+            timed_out = (ec == net::error::timed_out);
+        });
+        auto start = std::chrono::steady_clock::now();
+        io.run_for(2s);
+        EXPECT_TRUE(io.stopped());
+        EXPECT_TRUE(timed_out);
+        EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+    }
+
+    this->io_.stop();
+}
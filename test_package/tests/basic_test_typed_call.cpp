@@ -0,0 +1,62 @@
+#include "basic_test.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TYPED_TEST(BasicTest, test_typed_call)
+{
+    using client_type = typename TestFixture::client_type;
+
+    this->server_->async_serve_forever();
+    this->server_->dispatcher()->add("add", [](int a, int b) { return a + b; });
+    this->server_->dispatcher()->add(
+        "concat", [](std::string a, std::string b) { return a + b; });
+    this->async_run();
+    this->connect();
+
+    {
+        auto future = this->client_->template async_call_as<int>(
+            "add", std::tuple{12, 23}, use_future);
+        ASSERT_FUTURE_NO_BLOCK(future, 1s);
+        auto result = future.get();
+        ASSERT_TRUE(result);
+        EXPECT_EQ(35, *result);
+    }
+
+    {
+        std::promise<typename client_type::template call_result<std::string>> promise;
+        auto future = promise.get_future();
+        this->client_->template async_call_as<std::string>(
+            "concat",
+            std::tuple{"foo", "bar"},
+            [&](error_code ec,
+                typename client_type::template call_result<std::string> result) {
+                EXPECT_FALSE(ec);
+                promise.set_value(std::move(result));
+            });
+        ASSERT_FUTURE_NO_BLOCK(future, 1s);
+        auto result = future.get();
+        ASSERT_TRUE(result);
+        EXPECT_EQ("foobar", *result);
+    }
+
+    {
+        auto future = this->client_->template async_call_as<int>(
+            "unknown", use_future);
+        ASSERT_FUTURE_NO_BLOCK(future, 1s);
+        auto result = future.get();
+        ASSERT_FALSE(result);
+        EXPECT_EQ("unknown function", result.error().message);
+    }
+
+    {
+        // the result cannot be converted to an int
+        auto future = this->client_->template async_call_as<int>(
+            "concat", std::tuple{"foo", "bar"}, use_future);
+        ASSERT_FUTURE_NO_BLOCK(future, 1s);
+        auto result = future.get();
+        ASSERT_FALSE(result);
+        EXPECT_FALSE(result.error().message.empty());
+    }
+}
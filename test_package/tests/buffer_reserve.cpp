@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <packio/internal/buffer_reserve.h>
+#include <packio/internal/config.h>
+
+#if PACKIO_HAS_MSGPACK
+#include <packio/msgpack_rpc/rpc.h>
+#endif // PACKIO_HAS_MSGPACK
+
+using packio::internal::buffer_reserve;
+
+TEST(TestBufferReserve, test_grow)
+{
+    buffer_reserve reserve{4096, 65536};
+    ASSERT_EQ(4096u, reserve.size());
+
+    // a 100kB message fills every read until the maximum is reached
+    std::size_t remaining = 100'000;
+    int reads = 0;
+    while (remaining > 0) {
+        auto length = std::min(remaining, reserve.size());
+        reserve.on_read(length);
+        remaining -= length;
+        ++reads;
+    }
+    ASSERT_EQ(5, reads);
+    ASSERT_EQ(65536u, reserve.size());
+
+    reserve.on_read(65536);
+    ASSERT_EQ(65536u, reserve.size());
+}
+
+TEST(TestBufferReserve, test_shrink)
+{
+    buffer_reserve reserve{4096, 65536};
+    for (int i = 0; i < 4; ++i) {
+        reserve.on_read(reserve.size());
+    }
+    ASSERT_EQ(65536u, reserve.size());
+
+    // reads using at least half of the reservation keep it
+    ASSERT_FALSE(reserve.on_read(100));
+    ASSERT_FALSE(reserve.on_read(40000));
+    ASSERT_FALSE(reserve.on_read(100));
+    ASSERT_EQ(65536u, reserve.size());
+
+    // consecutive small reads shrink it, down to the minimum
+    ASSERT_TRUE(reserve.on_read(100));
+    ASSERT_EQ(32768u, reserve.size());
+    for (int i = 0; i < 100; ++i) {
+        reserve.on_read(100);
+    }
+    ASSERT_EQ(4096u, reserve.size());
+    ASSERT_FALSE(reserve.on_read(100));
+    ASSERT_FALSE(reserve.on_read(100));
+}
+
+TEST(TestBufferReserve, test_fixed)
+{
+    buffer_reserve reserve{4096, 4096};
+    reserve.on_read(4096);
+    ASSERT_EQ(4096u, reserve.size());
+
+    reserve.set_max(8192);
+    reserve.on_read(4096);
+    ASSERT_EQ(8192u, reserve.size());
+
+    reserve.set_min(16384);
+    ASSERT_EQ(16384u, reserve.size());
+    reserve.on_read(16384);
+    ASSERT_EQ(16384u, reserve.size());
+}
+
+#if PACKIO_HAS_MSGPACK
+TEST(TestBufferReserve, test_msgpack_big_message)
+{
+    using parser_type = packio::msgpack_rpc::rpc::incremental_parser_type;
+
+    const std::string payload(100'000, 'x');
+    ::msgpack::sbuffer message;
+    ::msgpack::packer<::msgpack::sbuffer> packer{message};
+    packer.pack_array(4);
+    packer.pack(1); // response
+    packer.pack(42);
+    packer.pack_nil();
+    packer.pack(payload);
+
+    // reads fill the whole parser buffer, the reservation only grows it
+    buffer_reserve reserve{4096, 1024 * 1024};
+    parser_type parser;
+    std::size_t offset = 0;
+    int reads = 0;
+    while (offset < message.size()) {
+        parser.reserve_buffer(reserve.size());
+        auto length = std::min(parser.buffer_capacity(), message.size() - offset);
+        std::memcpy(parser.buffer(), message.data() + offset, length);
+        parser.buffer_consumed(length);
+        reserve.on_read(length);
+        offset += length;
+        ++reads;
+    }
+    EXPECT_LE(reads, 3);
+
+    auto response = parser.get_response();
+    ASSERT_TRUE(response);
+    EXPECT_EQ(42u, response->id);
+    EXPECT_EQ(payload, response->result.as<std::string>());
+    EXPECT_EQ(0u, parser.unparsed_size());
+
+    // the grown buffer is released once the message is parsed
+    parser.shrink_buffer();
+    EXPECT_EQ(parser_type{}.buffer_capacity(), parser.buffer_capacity());
+}
+#endif // PACKIO_HAS_MSGPACK
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include <packio/internal/codel.h>
+
+using namespace std::chrono_literals;
+using packio::internal::codel;
+
+TEST(TestCodel, test_burst)
+{
+    codel controller{5ms, 100ms};
+    auto now = codel::clock_type::now();
+
+    // a burst is absorbed, only requests older than the interval are shed
+    for (int i = 0; i < 50; ++i) {
+        now += 1ms;
+        ASSERT_FALSE(controller.should_shed(std::chrono::milliseconds{i}, now));
+    }
+    ASSERT_TRUE(controller.should_shed(101ms, now));
+    ASSERT_FALSE(controller.overloaded());
+}
+
+TEST(TestCodel, test_standing_queue)
+{
+    codel controller{5ms, 100ms};
+    auto now = codel::clock_type::now();
+
+    // the delay stays above the target for a whole interval
+    for (int i = 0; i < 250; ++i) {
+        now += 1ms;
+        controller.should_shed(10ms, now);
+    }
+    ASSERT_TRUE(controller.overloaded());
+    ASSERT_TRUE(controller.should_shed(6ms, now));
+    ASSERT_FALSE(controller.should_shed(4ms, now));
+
+    // a single request below the target in an interval ends the overload
+    controller.should_shed(1ms, now);
+    for (int i = 0; i < 101; ++i) {
+        now += 1ms;
+        controller.should_shed(10ms, now);
+    }
+    ASSERT_FALSE(controller.overloaded());
+    ASSERT_FALSE(controller.should_shed(10ms, now));
+}
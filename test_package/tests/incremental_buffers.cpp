@@ -122,3 +122,22 @@ TEST(TestParser, test_partial_feed_complex)
         pos += feed_size;
     }
 }
+
+TEST(TestParser, test_mixed_object_array)
+{
+    incremental_buffers parser;
+    ASSERT_FALSE(parser.get_parsed_buffer());
+
+    const nlohmann::json obj = {{"key", 42}, {"nested", {"key", 12}}};
+    const nlohmann::json array = {obj, obj};
+    parser.feed(obj.dump() + array.dump(2) + " " + obj.dump());
+    parser.feed(" \n");
+    parser.feed(array.dump());
+
+    for (const auto& expected : {obj, array, obj, array}) {
+        auto buffer = parser.get_parsed_buffer();
+        ASSERT_TRUE(buffer);
+        ASSERT_EQ(nlohmann::json::parse(*buffer), expected);
+    }
+    ASSERT_FALSE(parser.get_parsed_buffer());
+}
@@ -0,0 +1,140 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <packio/internal/memo_cache.h>
+
+using namespace std::chrono_literals;
+using packio::internal::memo_cache;
+
+namespace {
+
+std::shared_ptr<const std::string> make_result(std::string value)
+{
+    return std::make_shared<const std::string>(std::move(value));
+}
+
+}
+
+TEST(TestMemoCache, test_single_flight)
+{
+    memo_cache cache{0s, 16};
+    std::vector<std::string> received;
+    auto make_waiter = [&] {
+        return memo_cache::waiter_type{
+            [&](memo_cache::result_type result, bool error) {
+                received.push_back(error ? "error: " + *result : *result);
+            }};
+    };
+
+    auto first = cache.lookup("a", make_waiter);
+    ASSERT_TRUE(first.leader);
+    ASSERT_FALSE(first.cached);
+    for (int i = 0; i < 3; ++i) {
+        auto waiting = cache.lookup("a", make_waiter);
+        ASSERT_FALSE(waiting.leader);
+        ASSERT_FALSE(waiting.cached);
+    }
+    // other keys are independent
+    ASSERT_TRUE(cache.lookup("b", make_waiter).leader);
+
+    cache.complete("a", make_result("42"), false);
+    ASSERT_EQ((std::vector<std::string>{"42", "42", "42"}), received);
+
+    // no time to live, the result is not cached
+    ASSERT_EQ(0u, cache.size());
+    ASSERT_TRUE(cache.lookup("a", make_waiter).leader);
+}
+
+TEST(TestMemoCache, test_failure)
+{
+    memo_cache cache{1min, 16};
+    std::vector<std::string> received;
+    auto make_waiter = [&] {
+        return memo_cache::waiter_type{
+            [&](memo_cache::result_type result, bool error) {
+                received.push_back(error ? "error: " + *result : *result);
+            }};
+    };
+
+    ASSERT_TRUE(cache.lookup("a", make_waiter).leader);
+    ASSERT_FALSE(cache.lookup("a", make_waiter).leader);
+    ASSERT_FALSE(cache.lookup("a", make_waiter).leader);
+    ASSERT_EQ(2u, cache.waiting());
+    cache.complete("a", make_result("failed"), true);
+    ASSERT_EQ(
+        (std::vector<std::string>{"error: failed", "error: failed"}), received);
+    ASSERT_EQ(0u, cache.waiting());
+
+    // errors are not cached
+    ASSERT_EQ(0u, cache.size());
+    ASSERT_TRUE(cache.lookup("a", make_waiter).leader);
+}
+
+TEST(TestMemoCache, test_ttl)
+{
+    memo_cache cache{100ms, 16};
+    auto make_waiter = [] { return memo_cache::waiter_type{}; };
+    auto now = memo_cache::clock_type::now();
+
+    ASSERT_TRUE(cache.lookup("a", make_waiter, now).leader);
+    cache.complete("a", make_result("42"), false, now);
+    ASSERT_EQ(1u, cache.size());
+
+    auto hit = cache.lookup("a", make_waiter, now + 99ms);
+    ASSERT_FALSE(hit.leader);
+    ASSERT_TRUE(hit.cached);
+    ASSERT_EQ("42", *hit.cached);
+
+    // expired
+    ASSERT_TRUE(cache.lookup("a", make_waiter, now + 100ms).leader);
+    ASSERT_EQ(0u, cache.size());
+}
+
+TEST(TestMemoCache, test_max_entries)
+{
+    memo_cache cache{100ms, 2};
+    auto make_waiter = [] { return memo_cache::waiter_type{}; };
+    auto now = memo_cache::clock_type::now();
+
+    for (std::string key : {"a", "b", "c"}) {
+        ASSERT_TRUE(cache.lookup(key, make_waiter, now).leader);
+        cache.complete(key, make_result(key), false, now);
+    }
+    // the cache is full, c is not cached
+    ASSERT_EQ(2u, cache.size());
+    ASSERT_TRUE(cache.lookup("a", make_waiter, now).cached);
+    ASSERT_TRUE(cache.lookup("c", make_waiter, now).leader);
+
+    // expired results make room
+    cache.complete("c", make_result("c"), false, now + 100ms);
+    ASSERT_EQ(1u, cache.size());
+    ASSERT_TRUE(cache.lookup("c", make_waiter, now + 100ms).cached);
+}
+
+TEST(TestMemoCache, test_recached)
+{
+    memo_cache cache{100ms, 2};
+    auto make_waiter = [] { return memo_cache::waiter_type{}; };
+    auto now = memo_cache::clock_type::now();
+
+    ASSERT_TRUE(cache.lookup("a", make_waiter, now).leader);
+    cache.complete("a", make_result("a1"), false, now);
+
+    // the expired result is computed and cached again,
+    // its first expiry does not evict the new result
+    ASSERT_TRUE(cache.lookup("a", make_waiter, now + 100ms).leader);
+    cache.complete("a", make_result("a2"), false, now + 100ms);
+    ASSERT_EQ(1u, cache.size());
+    auto hit = cache.lookup("a", make_waiter, now + 150ms);
+    ASSERT_TRUE(hit.cached);
+    ASSERT_EQ("a2", *hit.cached);
+
+    // the new expiry does
+    ASSERT_TRUE(cache.lookup("b", make_waiter, now + 200ms).leader);
+    cache.complete("b", make_result("b"), false, now + 200ms);
+    ASSERT_EQ(1u, cache.size());
+    ASSERT_TRUE(cache.lookup("a", make_waiter, now + 200ms).leader);
+}
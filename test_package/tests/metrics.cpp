@@ -0,0 +1,197 @@
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <packio/internal/metrics.h>
+#include <packio/metrics.h>
+
+using packio::histogram_snapshot;
+using packio::procedure_metrics_snapshot;
+using packio::session_metrics_snapshot;
+using packio::write_prometheus;
+using packio::internal::histogram;
+using packio::internal::histogram_layout;
+
+TEST(TestMetrics, test_histogram_layout)
+{
+    // every value falls in a bucket whose bounds contain it
+    std::vector<std::uint64_t> values{0, 1, 7, 8, 9, 15, 16, 17, 1000, 123456789};
+    for (std::uint64_t value = 1; value < (std::uint64_t{1} << 40); value *= 3) {
+        values.push_back(value);
+        values.push_back(value + 1);
+    }
+    for (auto value : values) {
+        auto index = histogram_layout::index(value);
+        ASSERT_LT(index, histogram_layout::kBuckets);
+        ASSERT_LE(histogram_layout::lower_bound(index), value) << value;
+        ASSERT_GE(histogram_layout::upper_bound(index), value) << value;
+        // relative error bounded by 1 / kSubBuckets
+        auto width = histogram_layout::upper_bound(index)
+                     - histogram_layout::lower_bound(index);
+        ASSERT_LE(width * histogram_layout::kSubBuckets, std::max<std::uint64_t>(value, 1))
+            << value;
+    }
+
+    // buckets are contiguous
+    for (std::size_t i = 1; i < histogram_layout::kBuckets; ++i) {
+        ASSERT_EQ(
+            histogram_layout::upper_bound(i - 1) + 1,
+            histogram_layout::lower_bound(i));
+    }
+
+    // large values are counted in the last bucket
+    ASSERT_EQ(
+        histogram_layout::kBuckets - 1,
+        histogram_layout::index(std::uint64_t{1} << 50));
+}
+
+TEST(TestMetrics, test_histogram_quantiles)
+{
+    histogram hist;
+    for (std::uint64_t i = 1; i <= 1000; ++i) {
+        hist.record(i * 1000);
+    }
+
+    histogram_snapshot snapshot;
+    hist.merge_into(snapshot.buckets, snapshot.count, snapshot.sum);
+    ASSERT_EQ(1000u, snapshot.count);
+    ASSERT_EQ(500500000u, snapshot.sum);
+    ASSERT_DOUBLE_EQ(500500., snapshot.mean());
+
+    for (double quantile : {0.5, 0.9, 0.99}) {
+        auto expected = quantile * 1000000;
+        auto value = static_cast<double>(snapshot.value_at_quantile(quantile));
+        ASSERT_GE(value, expected);
+        ASSERT_LE(value, expected * 1.125);
+    }
+    ASSERT_EQ(0u, snapshot.count_below_power_of_two(9));
+    ASSERT_EQ(1000u, snapshot.count_below_power_of_two(20));
+}
+
+TEST(TestMetrics, test_concurrent_recording)
+{
+    constexpr int kNThreads = 8;
+    constexpr int kNCalls = 10000;
+
+    packio::internal::procedure_metrics metrics;
+    auto empty = metrics.snapshot("add");
+    ASSERT_EQ(0u, empty.calls);
+    ASSERT_EQ(0u, empty.execution_time.count);
+    ASSERT_EQ(0u, empty.execution_time.value_at_quantile(0.5));
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kNThreads; ++i) {
+        threads.emplace_back([&metrics] {
+            for (int j = 0; j < kNCalls; ++j) {
+                metrics.record_call(
+                    std::chrono::microseconds{1},
+                    std::chrono::microseconds{j},
+                    j % 10 == 0);
+                metrics.record_write(std::chrono::microseconds{2});
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto snapshot = metrics.snapshot("add");
+    ASSERT_EQ("add", snapshot.name);
+    ASSERT_EQ(std::uint64_t{kNThreads * kNCalls}, snapshot.calls);
+    ASSERT_EQ(std::uint64_t{kNThreads * kNCalls / 10}, snapshot.errors);
+    ASSERT_EQ(std::uint64_t{kNThreads * kNCalls}, snapshot.queue_time.count);
+    ASSERT_EQ(std::uint64_t{kNThreads * kNCalls}, snapshot.execution_time.count);
+    ASSERT_EQ(std::uint64_t{kNThreads * kNCalls}, snapshot.write_time.count);
+    ASSERT_EQ(
+        std::uint64_t{kNThreads} * kNCalls * 1000, snapshot.queue_time.sum);
+}
+
+TEST(TestMetrics, test_prometheus)
+{
+    procedure_metrics_snapshot procedure;
+    procedure.name = "say \"hi\"";
+    procedure.calls = 3;
+    procedure.errors = 1;
+    procedure.execution_time.buckets.resize(histogram_layout::kBuckets);
+    procedure.execution_time.buckets[histogram_layout::index(1500)] = 2;
+    procedure.execution_time.buckets[histogram_layout::index(3000000)] = 1;
+    procedure.execution_time.count = 3;
+    procedure.execution_time.sum = 3003000;
+
+    std::string out;
+    write_prometheus(out, std::vector<procedure_metrics_snapshot>{procedure});
+    EXPECT_NE(
+        std::string::npos,
+        out.find("# TYPE packio_procedure_calls_total counter\n"));
+    EXPECT_NE(
+        std::string::npos,
+        out.find("packio_procedure_calls_total{procedure=\"say \\\"hi\\\"\"} 3\n"));
+    EXPECT_NE(
+        std::string::npos,
+        out.find("packio_procedure_errors_total{procedure=\"say \\\"hi\\\"\"} 1\n"));
+    EXPECT_NE(
+        std::string::npos,
+        out.find("# TYPE packio_procedure_execution_seconds histogram\n"));
+    EXPECT_NE(
+        std::string::npos,
+        out.find("packio_procedure_execution_seconds_bucket{procedure=\"say "
+                 "\\\"hi\\\"\",le=\"1.024e-06\"} 0\n"));
+    EXPECT_NE(
+        std::string::npos,
+        out.find("packio_procedure_execution_seconds_bucket{procedure=\"say "
+                 "\\\"hi\\\"\",le=\"4.096e-06\"} 2\n"));
+    EXPECT_NE(
+        std::string::npos,
+        out.find("packio_procedure_execution_seconds_bucket{procedure=\"say "
+                 "\\\"hi\\\"\",le=\"+Inf\"} 3\n"));
+    EXPECT_NE(
+        std::string::npos,
+        out.find("packio_procedure_execution_seconds_sum{procedure=\"say "
+                 "\\\"hi\\\"\"} 0.003003\n"));
+    EXPECT_NE(
+        std::string::npos,
+        out.find("packio_procedure_write_seconds_count{procedure=\"say "
+                 "\\\"hi\\\"\"} 0\n"));
+
+    session_metrics_snapshot sessions;
+    sessions.bytes_in = 10;
+    sessions.messages_out = 2;
+    out.clear();
+    write_prometheus(out, sessions, "rpc_");
+    EXPECT_NE(std::string::npos, out.find("rpc_session_bytes_in_total 10\n"));
+    EXPECT_NE(std::string::npos, out.find("rpc_session_bytes_out_total 0\n"));
+    EXPECT_NE(std::string::npos, out.find("rpc_session_messages_out_total 2\n"));
+}
+
+TEST(TestMetrics, test_prometheus_precision)
+{
+    procedure_metrics_snapshot procedure;
+    procedure.name = "big";
+    procedure.calls = 1234567890123;
+    procedure.execution_time.buckets.resize(histogram_layout::kBuckets);
+    procedure.execution_time.count = 1234567890123;
+    procedure.execution_time.sum = 123456789012345678;
+
+    std::string out;
+    write_prometheus(out, std::vector<procedure_metrics_snapshot>{procedure});
+
+    // counters are exact integers
+    EXPECT_NE(
+        std::string::npos,
+        out.find("packio_procedure_calls_total{procedure=\"big\"} 1234567890123\n"));
+    EXPECT_NE(
+        std::string::npos,
+        out.find("packio_procedure_execution_seconds_count{procedure=\"big\"} "
+                 "1234567890123\n"));
+
+    // the sum reads back to the same double
+    std::string sum_prefix =
+        "packio_procedure_execution_seconds_sum{procedure=\"big\"} ";
+    auto pos = out.find(sum_prefix);
+    ASSERT_NE(std::string::npos, pos);
+    auto sum = std::strtod(out.c_str() + pos + sum_prefix.size(), nullptr);
+    EXPECT_EQ(static_cast<double>(123456789012345678) / 1e9, sum);
+}
@@ -0,0 +1,91 @@
+#include <array>
+#include <chrono>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include <packio/internal/movable_function.h>
+#include <packio/packio.h>
+
+using packio::internal::movable_function;
+
+TEST(TestMovableFunction, test_move_only)
+{
+    movable_function<int(int)> fn = [ptr = std::make_unique<int>(40)](int i) {
+        return *ptr + i;
+    };
+    ASSERT_TRUE(fn);
+    ASSERT_EQ(42, fn(2));
+
+    auto moved = std::move(fn);
+    ASSERT_FALSE(fn);
+    ASSERT_TRUE(moved);
+    ASSERT_EQ(41, moved(1));
+
+    moved = nullptr;
+    ASSERT_FALSE(moved);
+    ASSERT_THROW(moved(0), std::bad_function_call);
+}
+
+TEST(TestMovableFunction, test_storage)
+{
+    using function = movable_function<int()>;
+    using small = std::pair<std::shared_ptr<int>, std::unique_ptr<int>>;
+    using large = std::array<char, function::inline_size + 1>;
+    static_assert(function::is_stored_inline_v<small>);
+    static_assert(!function::is_stored_inline_v<large>);
+
+    // both storages release the callable exactly once
+    auto counter = std::make_shared<int>(0);
+    {
+        function inline_fn = [counter] { return *counter; };
+        function heap_fn = [counter, data = large{}] {
+            return *counter + data[0];
+        };
+        ASSERT_EQ(3, counter.use_count());
+
+        auto moved_inline = std::move(inline_fn);
+        auto moved_heap = std::move(heap_fn);
+        ASSERT_EQ(3, counter.use_count());
+        ASSERT_EQ(0, moved_inline());
+        ASSERT_EQ(0, moved_heap());
+
+        moved_inline = std::move(moved_heap);
+        ASSERT_EQ(2, counter.use_count());
+    }
+    ASSERT_EQ(1, counter.use_count());
+}
+
+namespace {
+
+using hot_path_function = movable_function<
+    void(packio::error_code),
+    PACKIO_MOVABLE_FUNCTION_DEFAULT_INLINE_SIZE>;
+
+// wraps a call handler like the client does under an in-flight limit
+struct initiate_limited_call {
+    template <typename Handler>
+    void operator()(Handler&& handler) const
+    {
+        auto dispatching = [handler = std::forward<Handler>(handler)](
+                               packio::error_code ec) mutable { handler(ec); };
+        auto limited = [self = std::make_shared<int>(),
+                        start = std::chrono::steady_clock::now(),
+                        dispatching = std::move(dispatching)](
+                           packio::error_code ec) mutable { dispatching(ec); };
+        static_assert(hot_path_function::is_stored_inline_v<decltype(limited)>);
+
+        hot_path_function fn = std::move(limited);
+        fn({});
+    }
+};
+
+} // namespace
+
+TEST(TestMovableFunction, test_hot_path_handlers)
+{
+    using namespace packio;
+    auto future = net::async_initiate<const net::use_future_t<>&, void(error_code)>(
+        initiate_limited_call{}, net::use_future);
+    ASSERT_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds{0}));
+}
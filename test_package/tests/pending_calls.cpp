@@ -0,0 +1,69 @@
+#include <map>
+
+#include <gtest/gtest.h>
+
+#include <packio/internal/movable_function.h>
+#include <packio/internal/pending_calls.h>
+
+using handler_type = packio::internal::movable_function<int()>;
+using pending_calls =
+    packio::internal::pending_calls<handler_type, std::map>;
+
+TEST(TestPendingCalls, test_sequential)
+{
+    pending_calls calls;
+    ASSERT_TRUE(calls.empty());
+    ASSERT_FALSE(calls.take(0));
+
+    for (int i = 0; i < 1000; ++i) {
+        calls.insert(i, [i] { return i; });
+    }
+    ASSERT_EQ(1000u, calls.size());
+    ASSERT_FALSE(calls.take(1000));
+
+    for (int i = 0; i < 1000; ++i) {
+        auto handler = calls.take(i);
+        ASSERT_TRUE(handler);
+        ASSERT_EQ(i, handler());
+        ASSERT_FALSE(calls.take(i));
+    }
+    ASSERT_TRUE(calls.empty());
+}
+
+TEST(TestPendingCalls, test_long_lived_call)
+{
+    pending_calls calls;
+    calls.insert(0, [] { return 0; });
+
+    // one call stays pending while many others complete
+    for (int i = 1; i < 100000; ++i) {
+        calls.insert(i, [i] { return i; });
+        auto handler = calls.take(i);
+        ASSERT_TRUE(handler);
+        ASSERT_EQ(i, handler());
+    }
+
+    ASSERT_EQ(1u, calls.size());
+    auto handler = calls.take(0);
+    ASSERT_TRUE(handler);
+    ASSERT_EQ(0, handler());
+    ASSERT_TRUE(calls.empty());
+}
+
+TEST(TestPendingCalls, test_take_all)
+{
+    pending_calls calls;
+    calls.insert(0, [] { return 0; });
+    for (int i = 1; i < 500; ++i) {
+        calls.insert(i * 3, [i] { return i * 3; });
+    }
+    ASSERT_EQ(500u, calls.size());
+
+    int sum = 0;
+    for (auto& handler : calls.take_all()) {
+        sum += handler();
+    }
+    ASSERT_EQ(3 * 499 * 500 / 2, sum);
+    ASSERT_TRUE(calls.empty());
+    ASSERT_FALSE(calls.take(3));
+}
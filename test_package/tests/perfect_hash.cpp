@@ -0,0 +1,39 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <packio/internal/perfect_hash.h>
+
+using packio::internal::perfect_hash_map;
+
+TEST(TestPerfectHash, test_empty)
+{
+    perfect_hash_map<int> map{{}};
+    ASSERT_EQ(0u, map.size());
+    ASSERT_EQ(nullptr, map.find(""));
+    ASSERT_EQ(nullptr, map.find("add"));
+}
+
+TEST(TestPerfectHash, test_find)
+{
+    constexpr int kNNames = 1000;
+
+    std::vector<std::pair<std::string, int>> entries;
+    for (int i = 0; i < kNNames; ++i) {
+        entries.emplace_back("procedure_" + std::to_string(i), i);
+    }
+    entries.emplace_back("", -1);
+    perfect_hash_map<int> map{entries};
+    ASSERT_EQ(entries.size(), map.size());
+
+    for (const auto& [name, value] : entries) {
+        auto found = map.find(name);
+        ASSERT_NE(nullptr, found) << name;
+        ASSERT_EQ(value, *found);
+    }
+
+    ASSERT_EQ(nullptr, map.find("procedure_"));
+    ASSERT_EQ(nullptr, map.find("procedure_1000"));
+    ASSERT_EQ(nullptr, map.find("unknown"));
+}
@@ -0,0 +1,81 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <packio/internal/priority_scheduler.h>
+
+using packio::internal::priority_scheduler;
+
+TEST(TestPriorityScheduler, test_order)
+{
+    packio::net::io_context io;
+    auto scheduler = std::make_shared<priority_scheduler>(3);
+    ASSERT_EQ(3u, scheduler->levels());
+
+    std::vector<int> order;
+    auto post = [&](std::size_t priority, int id) {
+        scheduler->post(io.get_executor(), priority, [&order, id] {
+            order.push_back(id);
+        });
+    };
+    post(2, 0);
+    post(1, 1);
+    post(2, 2);
+    post(0, 3);
+    post(1, 4);
+    post(0, 5);
+    ASSERT_EQ(6u, scheduler->size());
+
+    io.run();
+    ASSERT_EQ((std::vector<int>{3, 5, 1, 4, 0, 2}), order);
+    ASSERT_EQ(0u, scheduler->size());
+}
+
+TEST(TestPriorityScheduler, test_overtake)
+{
+    packio::net::io_context io;
+    auto scheduler = std::make_shared<priority_scheduler>(2);
+
+    // a task posted while others are waiting runs next
+    std::vector<int> order;
+    for (int i = 0; i < 3; ++i) {
+        scheduler->post(io.get_executor(), 1, [&, i] {
+            order.push_back(i);
+            if (i == 0) {
+                scheduler->post(io.get_executor(), 0, [&] {
+                    order.push_back(10);
+                });
+            }
+        });
+    }
+
+    io.run();
+    ASSERT_EQ((std::vector<int>{0, 10, 1, 2}), order);
+}
+
+TEST(TestPriorityScheduler, test_executors)
+{
+    packio::net::io_context io1;
+    packio::net::io_context io2;
+    auto scheduler = std::make_shared<priority_scheduler>(2);
+
+    // tasks only run on the executor they were posted to,
+    // even when a more urgent task waits on another executor
+    std::vector<int> order1;
+    std::vector<int> order2;
+    scheduler->post(io1.get_executor(), 1, [&] { order1.push_back(0); });
+    scheduler->post(io2.get_executor(), 0, [&] { order2.push_back(1); });
+    scheduler->post(io1.get_executor(), 1, [&] { order1.push_back(2); });
+    scheduler->post(io2.get_executor(), 1, [&] { order2.push_back(3); });
+    scheduler->post(io1.get_executor(), 0, [&] { order1.push_back(4); });
+    ASSERT_EQ(5u, scheduler->size());
+
+    io1.run();
+    ASSERT_EQ((std::vector<int>{4, 0, 2}), order1);
+    ASSERT_TRUE(order2.empty());
+    ASSERT_EQ(2u, scheduler->size());
+
+    io2.run();
+    ASSERT_EQ((std::vector<int>{1, 3}), order2);
+    ASSERT_EQ(0u, scheduler->size());
+}
@@ -0,0 +1,117 @@
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <packio/internal/rcu.h>
+
+using packio::internal::rcu;
+
+namespace {
+
+struct tracked {
+    explicit tracked(int value, std::atomic<int>& alive)
+        : value{value}, alive{alive}
+    {
+        ++alive;
+    }
+    ~tracked() { --alive; }
+
+    int value;
+    std::atomic<int>& alive;
+};
+
+} // namespace
+
+TEST(TestRcu, test_publish)
+{
+    std::atomic<int> alive{0};
+    rcu<tracked> domain;
+    ASSERT_EQ(nullptr, domain.read().first);
+
+    domain.publish(std::make_unique<const tracked>(1, alive));
+    {
+        auto [value, guard] = domain.read();
+        ASSERT_NE(nullptr, value);
+        ASSERT_EQ(1, value->value);
+    }
+
+    // no reader: the previous value is deleted immediately
+    domain.publish(std::make_unique<const tracked>(2, alive));
+    ASSERT_EQ(1, alive.load());
+    ASSERT_EQ(0u, domain.retired());
+    ASSERT_EQ(2, domain.read().first->value);
+}
+
+TEST(TestRcu, test_reader_keeps_value)
+{
+    std::atomic<int> alive{0};
+    rcu<tracked> domain;
+    domain.publish(std::make_unique<const tracked>(1, alive));
+
+    auto [value, guard] = domain.read();
+    domain.publish(std::make_unique<const tracked>(2, alive));
+    domain.publish(std::make_unique<const tracked>(3, alive));
+    ASSERT_EQ(1, value->value);
+    ASSERT_EQ(3, alive.load());
+    ASSERT_EQ(3, domain.read().first->value);
+
+    // a reader started after the publication does not hold the value
+    auto [current, current_guard] = domain.read();
+    ASSERT_EQ(3, current->value);
+
+    // releasing the first guard reclaims the value it held, the current
+    // reader conservatively delays the values retired in its epoch
+    guard.release();
+    ASSERT_EQ(2, alive.load());
+    ASSERT_EQ(1u, domain.retired());
+    ASSERT_EQ(3, current->value);
+
+    current_guard.release();
+    ASSERT_EQ(1, alive.load());
+    ASSERT_EQ(0u, domain.retired());
+}
+
+TEST(TestRcu, test_concurrent_readers)
+{
+    constexpr int kNThreads = 4;
+    constexpr int kNPublications = 2000;
+
+    std::atomic<int> alive{0};
+    {
+        rcu<tracked> domain;
+        domain.publish(std::make_unique<const tracked>(0, alive));
+
+        std::atomic<bool> done{false};
+        std::atomic<int> errors{0};
+        std::vector<std::thread> readers;
+        for (int i = 0; i < kNThreads; ++i) {
+            readers.emplace_back([&] {
+                int last = 0;
+                while (!done.load()) {
+                    auto [value, guard] = domain.read();
+                    // values are published in order and never seen deleted
+                    if (value->value < last || value->alive.load() <= 0) {
+                        ++errors;
+                    }
+                    last = value->value;
+                }
+            });
+        }
+
+        for (int i = 1; i <= kNPublications; ++i) {
+            domain.publish(std::make_unique<const tracked>(i, alive));
+        }
+        done = true;
+        for (auto& thread : readers) {
+            thread.join();
+        }
+
+        ASSERT_EQ(0, errors.load());
+        domain.publish(std::make_unique<const tracked>(-1, alive));
+        ASSERT_EQ(1, alive.load());
+    }
+    ASSERT_EQ(0, alive.load());
+}
@@ -0,0 +1,78 @@
+#include <future>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <packio/packio.h>
+
+#include "misc.h"
+
+using namespace std::chrono_literals;
+using namespace packio::net;
+using namespace packio;
+
+TEST(TestServerPool, test_reuse_port)
+{
+    constexpr std::size_t kNServers = 4;
+    constexpr int kNClients = 32;
+    using server_pool_type = default_rpc::server_pool<ip::tcp::acceptor>;
+    using client_type = default_rpc::client<ip::tcp::socket>;
+
+    // the first acceptor picks the port, the others share it
+    ip::tcp::endpoint endpoint{ip::address_v4::loopback(), 0};
+    server_pool_type pool{kNServers, [&](io_context& ctx) {
+                              auto acceptor = make_reuse_port_acceptor(ctx, endpoint);
+                              endpoint = acceptor.local_endpoint();
+                              return acceptor;
+                          }};
+    ASSERT_EQ(kNServers, pool.size());
+    pool.set_session_max_pending_requests(64);
+    pool.set_session_max_queued_response_bytes(1 << 20);
+    ASSERT_EQ(64u, pool.get_session_max_pending_requests());
+    ASSERT_EQ(1u << 20, pool.get_session_max_queued_response_bytes());
+    for (const auto& server : pool.servers()) {
+        ASSERT_EQ(pool.dispatcher(), server->dispatcher());
+        ASSERT_EQ(endpoint, server->acceptor().local_endpoint());
+        ASSERT_EQ(64u, server->get_session_max_pending_requests());
+        ASSERT_EQ(1u << 20, server->get_session_max_queued_response_bytes());
+    }
+
+    pool.dispatcher()->add("add", [](int a, int b) { return a + b; });
+    pool.async_serve_forever();
+    pool.run();
+
+    io_context client_ctx;
+    auto guard = make_work_guard(client_ctx);
+    std::thread client_thread{[&] { client_ctx.run(); }};
+
+    std::vector<std::shared_ptr<client_type>> clients;
+    std::vector<std::future<client_type::response_type>> futures;
+    for (int i = 0; i < kNClients; ++i) {
+        clients.push_back(std::make_shared<client_type>(ip::tcp::socket{client_ctx}));
+        clients.back()->socket().connect(endpoint);
+        futures.push_back(
+            clients.back()->async_call("add", std::tuple{i, 1}, use_future));
+    }
+    for (int i = 0; i < kNClients; ++i) {
+        EXPECT_RESULT_EQ(futures[i], i + 1);
+    }
+    ASSERT_EQ(static_cast<std::uint64_t>(kNClients), pool.get_accepted_sessions());
+    ASSERT_EQ(static_cast<std::size_t>(kNClients), pool.get_active_sessions());
+
+#if defined(__linux__)
+    // the kernel spreads the connections among the acceptors
+    std::size_t used_servers = 0;
+    for (const auto& server : pool.servers()) {
+        used_servers += server->get_accepted_sessions() > 0;
+    }
+    ASSERT_GT(used_servers, 1u);
+#endif // defined(__linux__)
+
+    clients.clear();
+    guard.reset();
+    client_ctx.stop();
+    client_thread.join();
+    pool.stop();
+    pool.join();
+}
@@ -0,0 +1,88 @@
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <packio/internal/token_bucket.h>
+
+using namespace std::chrono_literals;
+using packio::internal::token_bucket;
+
+TEST(TestTokenBucket, test_disabled)
+{
+    token_bucket bucket;
+    ASSERT_FALSE(bucket.enabled());
+    ASSERT_EQ(0., bucket.rate());
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(bucket.try_acquire());
+    }
+}
+
+TEST(TestTokenBucket, test_burst_and_refill)
+{
+    token_bucket bucket{10., 3};
+    ASSERT_TRUE(bucket.enabled());
+    ASSERT_EQ(10., bucket.rate());
+    ASSERT_EQ(3u, bucket.burst());
+
+    auto now = token_bucket::clock_type::now();
+    ASSERT_TRUE(bucket.try_acquire(now));
+    ASSERT_TRUE(bucket.try_acquire(now));
+    ASSERT_TRUE(bucket.try_acquire(now));
+    ASSERT_FALSE(bucket.try_acquire(now));
+
+    // one token every 100ms
+    ASSERT_FALSE(bucket.try_acquire(now + 99ms));
+    ASSERT_TRUE(bucket.try_acquire(now + 100ms));
+    ASSERT_FALSE(bucket.try_acquire(now + 100ms));
+
+    // the bucket does not hold more than the burst
+    now += 10s;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(bucket.try_acquire(now));
+    }
+    ASSERT_FALSE(bucket.try_acquire(now));
+
+    bucket.set_rate(0., 1);
+    ASSERT_FALSE(bucket.enabled());
+    ASSERT_TRUE(bucket.try_acquire(now));
+}
+
+TEST(TestTokenBucket, test_release)
+{
+    token_bucket bucket{10., 2};
+    auto now = token_bucket::clock_type::now();
+    ASSERT_TRUE(bucket.try_acquire(now));
+    ASSERT_TRUE(bucket.try_acquire(now));
+    ASSERT_FALSE(bucket.try_acquire(now));
+
+    // a released token can be taken again
+    bucket.release();
+    ASSERT_TRUE(bucket.try_acquire(now));
+    ASSERT_FALSE(bucket.try_acquire(now));
+}
+
+TEST(TestTokenBucket, test_concurrent)
+{
+    constexpr int kNThreads = 8;
+    constexpr int kNTries = 1000;
+
+    // no refill during the test
+    token_bucket bucket{1e-3, 100};
+    auto now = token_bucket::clock_type::now();
+    std::atomic<int> acquired{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kNThreads; ++i) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < kNTries; ++j) {
+                if (bucket.try_acquire(now)) {
+                    ++acquired;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(100, acquired.load());
+}